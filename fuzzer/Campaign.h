@@ -0,0 +1,174 @@
+#pragma once
+#include <chrono>
+#include <map>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <libfuzzer/Logger.h>
+#include "Utils.h"
+
+/* Rounds stop once the time left for each contract falls below it */
+static int CAMPAIGN_MIN_SLICE = 10;
+
+/* A contract of a campaign and what its runs reported */
+struct CampaignJob {
+  string name;
+  ContractInfo info;
+  int rounds = 0;
+  /* Seconds of all its runs */
+  double spent = 0;
+  bool saturated = false;
+  /* Its last run crashed or had nothing to fuzz */
+  bool failed = false;
+  /* stats.json of its last run */
+  pt::ptree stats;
+};
+
+pt::ptree readStats(CampaignJob const& job) {
+  pt::ptree stats;
+  auto statsFile = job.info.contractName + "/stats.json";
+  if (!exists(statsFile)) return stats;
+  try {
+    pt::read_json(statsFile, stats);
+  } catch (pt::json_parser_error const&) {}
+  return stats;
+}
+
+/* Fuzz the contracts of the round, up to numProcesses forked runs at a time */
+void runRound(vector<CampaignJob> &campaign, vector<size_t> const& pending, vector<ContractInfo> const& assets, FuzzParam param, int duration, int numProcesses, fuzzer::Logger::Level logLevel) {
+  map<pid_t, pair<size_t, chrono::steady_clock::time_point>> running;
+  auto waitOne = [&]() {
+    int status = 0;
+    auto pid = waitpid(-1, &status, 0);
+    auto it = running.find(pid);
+    if (it == running.end()) return;
+    auto &job = campaign[it->second.first];
+    double elapsed = chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - it->second.second).count();
+    running.erase(it);
+    job.spent += elapsed;
+    job.rounds ++;
+    job.stats = readStats(job);
+    /* Failed runs are not retried, stats.json is whatever they wrote last */
+    job.failed = !WIFEXITED(status) || WEXITSTATUS(status);
+    if (job.failed) {
+      job.saturated = true;
+      if (WIFSIGNALED(status)) cout << "[x] " << job.name << " killed by signal " << WTERMSIG(status) << endl;
+      else cout << "[x] " << job.name << " exited with status " << WEXITSTATUS(status) << endl;
+      return;
+    }
+    /* Stopped on its own before its time, or nothing new in the second half of the run */
+    auto runDuration = job.stats.get<double>("duration", elapsed);
+    job.saturated = elapsed + 1 < duration || job.stats.get<double>("lastNewPath", 0) < runDuration / 2;
+    cout << "[+] " << job.name << " " << (job.saturated ? "saturated" : "still finding new paths") << " after " << (int) job.spent << "s" << endl;
+  };
+  for (auto idx : pending) {
+    while ((int) running.size() >= numProcesses) waitOne();
+    auto &job = campaign[idx];
+    auto fuzzParam = param;
+    fuzzParam.contractInfo = assets;
+    fuzzParam.contractInfo.push_back(job.info);
+    fuzzParam.duration = duration;
+    /* Later rounds continue from the corpus of the previous one */
+    fuzzParam.resume = param.resume || job.rounds > 0;
+    auto pid = fork();
+    if (!pid) {
+      /* The writer thread of the logger is started by the child which logs */
+      fuzzer::Logger::setLevel(logLevel);
+      Fuzzer fuzzer(fuzzParam);
+      /* Exits through stop(), with 0 once the run is over */
+      fuzzer.start();
+      _exit(1);
+    }
+    if (pid < 0) {
+      cout << "[x] Can not fork for " << job.name << endl;
+      job.saturated = true;
+      continue;
+    }
+    running[pid] = make_pair(idx, chrono::steady_clock::now());
+  }
+  while (running.size()) waitOne();
+}
+
+/* Per contract stats and the number of contracts each oracle fired on */
+void writeCampaign(vector<CampaignJob> const& campaign) {
+  pt::ptree root;
+  pt::ptree contracts;
+  map<string, int> vulnerabilities;
+  uint64_t totalExecs = 0;
+  double spent = 0;
+  int failed = 0;
+  cout << ">> Campaign" << endl;
+  for (auto const& job : campaign) {
+    auto stats = job.stats;
+    stats.put("name", job.name);
+    stats.put("rounds", job.rounds);
+    stats.put("spent", job.spent);
+    stats.put("saturated", job.saturated);
+    stats.put("failed", job.failed);
+    contracts.push_back(make_pair("", stats));
+    totalExecs += job.stats.get<uint64_t>("totalExecs", 0);
+    spent += job.spent;
+    failed += job.failed;
+    string found = "";
+    if (auto oracles = job.stats.get_child_optional("vulnerabilities")) {
+      for (auto const& oracle : *oracles) {
+        if (!oracle.second.get_value<bool>(false)) continue;
+        vulnerabilities[oracle.first] += 1;
+        found += " " + oracle.first;
+      }
+    }
+    cout << padStr(job.name, 30) << " rounds: " << job.rounds << " time: " << (int) job.spent << "s";
+    cout << " branches: " << job.stats.get<uint64_t>("coveredBranches", 0) << " found:" << (found.empty() ? " none" : found) << endl;
+  }
+  root.add_child("contracts", contracts);
+  root.put("totalExecs", totalExecs);
+  root.put("spent", spent);
+  root.put("failed", failed);
+  for (auto const& it : vulnerabilities) root.put("vulnerabilities." + it.first, it.second);
+  std::ofstream out("campaign.json");
+  pt::write_json(out, root);
+  cout << "[+] " << campaign.size() << " contracts, " << failed << " failed, " << totalExecs << " execs, report in campaign.json" << endl;
+}
+
+/*
+ * Fuzz every compiled contract of a folder, numProcesses at a time. Assets
+ * and contracts are parsed once before forking. The campaign process never
+ * logs, so children fork without the writer thread and log at logLevel.
+ * Every contract is granted param.duration seconds: the first round runs
+ * half of it, contracts which stopped early or found nothing in the second
+ * half of their run are saturated and later rounds share the time left
+ * among the others
+ */
+void runCampaign(string contractsFolder, string assetsFolder, FuzzParam param, int numProcesses, fuzzer::Logger::Level logLevel) {
+  fuzzer::Logger::setLevel(fuzzer::Logger::NONE);
+  auto assets = parseAssets(assetsFolder);
+  vector<CampaignJob> campaign;
+  unordered_set<string> contractNames;
+  forEachFile(contractsFolder, ".sol", [&](directory_entry file) {
+    auto filePath = file.path().string();
+    auto contractName = toContractName(file);
+    if (!contractNames.insert(contractName).second) return;
+    if (!exists(filePath + ".json")) {
+      cout << "[x] " << filePath << " is not compiled, run the solc lines of fuzzMe" << endl;
+      return;
+    }
+    CampaignJob job;
+    job.name = contractName;
+    job.info = parseSource(filePath, filePath + ".json", contractName, true);
+    campaign.push_back(job);
+  });
+  double budget = (double) param.duration * campaign.size();
+  for (int round = 0; ; round ++) {
+    vector<size_t> pending;
+    double spent = 0;
+    for (size_t i = 0; i < campaign.size(); i ++) {
+      spent += campaign[i].spent;
+      if (!campaign[i].saturated) pending.push_back(i);
+    }
+    if (pending.empty()) break;
+    int duration = round ? (int) ((budget - spent) / pending.size()) : max(param.duration / 2, 1);
+    if (round && duration < CAMPAIGN_MIN_SLICE) break;
+    cout << ">> Round " << round + 1 << ": " << pending.size() << " contracts, " << duration << "s each" << endl;
+    runRound(campaign, pending, assets, param, duration, numProcesses, logLevel);
+  }
+  writeCampaign(campaign);
+}
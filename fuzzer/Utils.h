@@ -1,3 +1,4 @@
+#pragma once
 #include <iostream>
 #include <boost/algorithm/string.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -114,7 +115,7 @@ string compileSolFiles(string folder) {
   return ret.str();
 }
 
-string fuzzJsonFiles(string contracts, string assets, int duration, int mode, int reporter, string attackerName) {
+string fuzzJsonFiles(string contracts, string assets, int duration, int mode, int reporter, int jobs, string attackerName, bool resume, int schedule) {
   stringstream ret;
   unordered_set<string> contractNames;
   /* search for sol file */
@@ -130,7 +131,10 @@ string fuzzJsonFiles(string contracts, string assets, int duration, int mode, in
     ret << " --duration " + to_string(duration);
     ret << " --mode " + to_string(mode);
     ret << " --reporter " + to_string(reporter);
+    ret << " --jobs " + to_string(jobs);
+    ret << " --schedule " + to_string(schedule);
     ret << " --attacker " + attackerName;
+    if (resume) ret << " --resume";
     ret << endl;
   });
   return ret.str();
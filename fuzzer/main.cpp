@@ -1,6 +1,9 @@
 #include <iostream>
+#include <thread>
 #include <libfuzzer/Fuzzer.h>
+#include <libfuzzer/Logger.h>
 #include "Utils.h"
+#include "Campaign.h"
 
 using namespace std;
 using namespace fuzzer;
@@ -8,7 +11,9 @@ using namespace fuzzer;
 static int DEFAULT_MODE = AFL;
 static int DEFAULT_DURATION = 120; // 2 mins
 static int DEFAULT_REPORTER = JSON;
-static int DEFAULT_ANALYZING_INTERVAL = 5; // 5 sec
+static int DEFAULT_JOBS = 1;
+static int DEFAULT_SCHEDULE = EXPLOIT;
+static int DEFAULT_LOG_LEVEL = fuzzer::Logger::DEBUG;
 static string DEFAULT_CONTRACTS_FOLDER = "contracts/";
 static string DEFAULT_ASSETS_FOLDER = "assets/";
 static string DEFAULT_ATTACKER = "ReentrancyAttacker";
@@ -22,12 +27,19 @@ int main(int argc, char* argv[]) {
   int mode = DEFAULT_MODE;
   int duration = DEFAULT_DURATION;
   int reporter = DEFAULT_REPORTER;
+  int jobs = DEFAULT_JOBS;
+  int schedule = DEFAULT_SCHEDULE;
+  int logLevel = DEFAULT_LOG_LEVEL;
   string contractsFolder = DEFAULT_CONTRACTS_FOLDER;
   string assetsFolder = DEFAULT_ASSETS_FOLDER;
   string jsonFile = "";
   string contractName = "";
   string sourceFile = "";
   string attackerName = DEFAULT_ATTACKER;
+  string seedsDir = "";
+  string campaignFolder = "";
+  vector<string> cminFolders;
+  vector<string> tminFiles;
   po::options_description desc("Allowed options");
   po::variables_map vm;
   
@@ -42,9 +54,18 @@ int main(int argc, char* argv[]) {
     ("mode,m", po::value(&mode), "choose mode: 0 - AFL ")
     ("reporter,r", po::value(&reporter), "choose reporter: 0 - TERMINAL | 1 - JSON")
     ("duration,d", po::value(&duration), "fuzz duration")
-    ("attacker", po::value(&attackerName), "choose attacker: NormalAttacker | ReentrancyAttacker");
+    ("jobs,j", po::value(&jobs), "number of fuzzing threads, half of them execute testcases")
+    ("schedule", po::value(&schedule), "choose power schedule: 0 - EXPLOIT | 1 - FAST | 2 - COE | 3 - DISTANCE")
+    ("log", po::value(&logLevel), "choose log level: 0 - DEBUG | 1 - INFO | 2 - NONE")
+    ("attacker", po::value(&attackerName), "choose attacker: NormalAttacker | ReentrancyAttacker")
+    ("resume", "continue from the corpus of the previous run")
+    ("seeds", po::value(&seedsDir), "folder of testcases to start from")
+    ("cmin", po::value(&cminFolders)->multitoken(), "minimize the corpus of <in> into <out>")
+    ("tmin", po::value(&tminFiles)->multitoken(), "trim the testcase <in> into <out>")
+    ("campaign", po::value(&campaignFolder), "fuzz every compiled contract of a folder, --jobs at a time");
   po::store(po::parse_command_line(argc, argv, desc), vm);
   po::notify(vm);
+  fuzzer::Logger::setLevel((fuzzer::Logger::Level) logLevel);
   /* Show help message */
   if (vm.count("help")) showHelp(desc);
   /* Generate working scripts */
@@ -53,11 +74,30 @@ int main(int argc, char* argv[]) {
     fuzzMe << "#!/bin/bash" << endl;
     fuzzMe << compileSolFiles(contractsFolder);
     fuzzMe << compileSolFiles(assetsFolder);
-    fuzzMe << fuzzJsonFiles(contractsFolder, assetsFolder, duration, mode, reporter, attackerName);
+    fuzzMe << fuzzJsonFiles(contractsFolder, assetsFolder, duration, mode, reporter, jobs, attackerName, vm.count("resume"), schedule);
     fuzzMe.close();
     showGenerate();
     return 0;
   }
+  /* Fuzz a folder of contracts, one process per contract */
+  if (vm.count("campaign")) {
+    FuzzParam fuzzParam;
+    fuzzParam.mode = (FuzzMode) mode;
+    fuzzParam.duration = duration;
+    /* Children share the terminal, stats.json is read back */
+    fuzzParam.reporter = JSON;
+    fuzzParam.jobs = 1;
+    fuzzParam.attackerName = attackerName;
+    fuzzParam.resume = vm.count("resume");
+    fuzzParam.seedsDir = seedsDir;
+    fuzzParam.schedule = (PowerSchedule) schedule;
+    /* Children would interleave their lines in the same files */
+    auto childLogLevel = vm.count("log") ? (fuzzer::Logger::Level) logLevel : fuzzer::Logger::NONE;
+    /* Every child runs a worker and an executor */
+    auto numProcesses = vm.count("jobs") ? max(jobs, 1) : max((int) thread::hardware_concurrency() / 2, 1);
+    runCampaign(campaignFolder, assetsFolder, fuzzParam, numProcesses, childLogLevel);
+    return 0;
+  }
   /* Fuzz a single contract */
   if (vm.count("file") && vm.count("name") && vm.count("source")) {
     FuzzParam fuzzParam;
@@ -67,8 +107,33 @@ int main(int argc, char* argv[]) {
     fuzzParam.mode = (FuzzMode) mode;
     fuzzParam.duration = duration;
     fuzzParam.reporter = (Reporter) reporter;
-    fuzzParam.analyzingInterval = DEFAULT_ANALYZING_INTERVAL;
+    fuzzParam.jobs = max(jobs, 1);
     fuzzParam.attackerName = attackerName;
+    fuzzParam.resume = vm.count("resume");
+    fuzzParam.seedsDir = seedsDir;
+    fuzzParam.schedule = (PowerSchedule) schedule;
+    if (vm.count("cmin")) {
+      if (cminFolders.size() != 2) {
+        showHelp(desc);
+        return 0;
+      }
+      /* Replay on every core unless told otherwise */
+      if (!vm.count("jobs")) fuzzParam.jobs = max(thread::hardware_concurrency(), 1u);
+      Fuzzer minimizer(fuzzParam);
+      cout << ">> Minimize " << contractName << endl;
+      minimizer.minimize(cminFolders[0], cminFolders[1]);
+      return 0;
+    }
+    if (vm.count("tmin")) {
+      if (tminFiles.size() != 2) {
+        showHelp(desc);
+        return 0;
+      }
+      Fuzzer trimmer(fuzzParam);
+      cout << ">> Trim " << contractName << endl;
+      trimmer.trim(tminFiles[0], tminFiles[1]);
+      return 0;
+    }
     Fuzzer fuzzer(fuzzParam);
     cout << ">> Fuzz " << contractName << endl;
     fuzzer.start();
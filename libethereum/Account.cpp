@@ -47,6 +47,10 @@ u256 Account::originalStorageValue(u256 const& _key, OverlayDB const& _db) const
     if (it != m_storageOriginal.end())
         return it->second;
 
+    // Nothing was ever committed for this account, skip the trie lookup.
+    if (m_storageRoot == EmptyTrie)
+        return 0;
+
     // Not in the original values cache - go to the DB.
     SecureTrieDB<h256, OverlayDB> const memdb(const_cast<OverlayDB*>(&_db), m_storageRoot);
     std::string const payload = memdb.at(_key);
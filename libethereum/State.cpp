@@ -54,7 +54,8 @@ State::State(State const& _s):
     m_unchangedCacheEntries(_s.m_unchangedCacheEntries),
     m_nonExistingAccountsCache(_s.m_nonExistingAccountsCache),
     m_touched(_s.m_touched),
-    m_accountStartNonce(_s.m_accountStartNonce)
+    m_accountStartNonce(_s.m_accountStartNonce),
+    m_flat(_s.m_flat)
 {}
 
 OverlayDB State::openDB(fs::path const& _basePath, h256 const& _genesisHash, WithExisting _we)
@@ -141,9 +142,18 @@ State& State::operator=(State const& _s)
     m_nonExistingAccountsCache = _s.m_nonExistingAccountsCache;
     m_touched = _s.m_touched;
     m_accountStartNonce = _s.m_accountStartNonce;
+    m_flat = _s.m_flat;
     return *this;
 }
 
+size_t State::cacheMemory() const
+{
+    size_t ret = 0;
+    for (auto const& i: m_cache)
+        ret += sizeof(Account) + i.second.code().size() + i.second.storageOverlay().size() * 2 * sizeof(u256);
+    return ret;
+}
+
 Account const* State::account(Address const& _a) const
 {
     return const_cast<State*>(this)->account(_a);
@@ -155,6 +165,9 @@ Account* State::account(Address const& _addr)
     if (it != m_cache.end())
         return &it->second;
 
+    if (m_flat)
+        return nullptr;
+
     if (m_nonExistingAccountsCache.count(_addr))
         return nullptr;
 
@@ -199,6 +212,9 @@ void State::clearCacheIfTooLarge() const
 
 void State::commit(CommitBehaviour _commitBehaviour)
 {
+    // A flat state has no trie to commit into, silently dropping the cache would lose the changes.
+    if (m_flat)
+        BOOST_THROW_EXCEPTION(InterfaceNotSupported() << errinfo_interface("State::commit() on a flat state"));
     if (_commitBehaviour == CommitBehaviour::RemoveEmptyAccounts)
         removeEmptyAccounts();
     m_touched += dev::eth::commit(m_cache, m_state);
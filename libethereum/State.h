@@ -184,6 +184,13 @@ public:
     enum NullType { Null };
     State(NullType): State(Invalid256, OverlayDB(), BaseState::Empty) {}
 
+    /// State living in the account cache only, without trie or database behind it.
+    /// Accounts and storage never written read as empty, the changelog is the undo journal.
+    /// Meant for executing transactions in isolation, e.g. fuzzing; commit() throws InterfaceNotSupported.
+    enum FlatType { Flat };
+    State(u256 const& _accountStartNonce, FlatType):
+        State(_accountStartNonce, OverlayDB(), BaseState::PreExisting) { m_flat = true; }
+
     /// Copy state object.
     State(State const& _s);
 
@@ -331,6 +338,9 @@ public:
 
     ChangeLog const& changeLog() const { return m_changeLog; }
 
+    /// @returns an estimate of the memory held by cached accounts, to budget copies of the state.
+    size_t cacheMemory() const;
+
 private:
     /// Turns all "touched" empty accounts into non-alive accounts.
     void removeEmptyAccounts();
@@ -368,6 +378,9 @@ private:
 
     u256 m_accountStartNonce;
 
+    /// Accounts missing from the cache do not exist, the trie is never consulted.
+    bool m_flat = false;
+
     friend std::ostream& operator<<(std::ostream& _out, State const& _s);
     ChangeLog m_changeLog;
 };
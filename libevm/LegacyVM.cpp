@@ -36,7 +36,9 @@ template <class S> S modWorkaround(S const& _a, S const& _b)
     return (S)(s512(_a) % s512(_b));
 }
 
-bytes LegacyVM::payload = bytes(0, 0);
+thread_local bytes LegacyVM::payload = bytes(0, 0);
+thread_local std::bitset<256> LegacyVM::hookedInstructions = std::bitset<256>().set();
+thread_local uint64_t LegacyVM::faultPC = 0;
 
 //
 // for decoding destinations of JUMPTO, JUMPV, JUMPSUB and JUMPSUBV
@@ -72,7 +74,7 @@ uint64_t LegacyVM::decodeJumpvDest(const byte* const _code, uint64_t& _pc, byte
 //
 // for tracing, checking, metering, measuring ...
 //
-void LegacyVM::onOperation()
+void LegacyVM::reportOperation()
 {
     if (m_onOp)
         (m_onOp)(++m_nSteps, m_PC, m_OP,
@@ -222,7 +224,8 @@ owning_bytes_ref LegacyVM::exec(u256& _io_gas, ExtVMFace& _ext, OnOpFunc const&
     m_ext = &_ext;
     m_schedule = &m_ext->evmSchedule();
     m_onOp = _onOp;
-    m_onFail = &LegacyVM::onOperation; // this results in operations that fail being logged twice in the trace
+    m_hooked = m_onOp ? hookedInstructions : std::bitset<256>();
+    m_onFail = &LegacyVM::reportOperation; // this results in operations that fail being logged twice in the trace
     m_PC = 0;
 
     try
@@ -236,6 +239,7 @@ owning_bytes_ref LegacyVM::exec(u256& _io_gas, ExtVMFace& _ext, OnOpFunc const&
     }
     catch (...)
     {
+        faultPC = m_PC;
         *m_io_gas_p = m_io_gas;
         throw;
     }
@@ -20,6 +20,7 @@
 #include "Instruction.h"
 #include "LegacyVMConfig.h"
 #include "VMFace.h"
+#include <bitset>
 
 namespace dev
 {
@@ -43,7 +44,28 @@ public:
         reverse(stack.begin(), stack.end());
         return stack;
     };
-    static bytes payload;
+    /// Non-allocating accessors for instrumentation hooks.
+    /// stackTop(0) is the top of the stack, the caller checks _i < stackSize().
+    u256 const& stackTop(size_t _i) const { return m_SP[_i]; }
+    size_t stackSize() const { return m_stackEnd - m_SP; }
+    /// View of memory clipped to the bytes allocated so far, the caller pads what lies past msize.
+    bytesConstRef memoryRef(u256 const& _offset, u256 const& _size) const
+    {
+        if (_offset >= m_mem.size())
+            return bytesConstRef();
+        size_t offset = static_cast<size_t>(_offset);
+        size_t size = static_cast<size_t>(std::min<u256>(_size, m_mem.size() - offset));
+        return bytesConstRef(m_mem.data() + offset, size);
+    }
+    /// Output of the last direct subcall.
+    bytes const& returnData() const { return m_returnData; }
+    /// Call data forwarded by the fuzzer's attacker agent; one per fuzzing thread.
+    static thread_local bytes payload;
+    /// Instructions reported to the onOp hook by VMs created on this thread, all by default.
+    /// Failing operations are reported regardless of the mask.
+    static thread_local std::bitset<256> hookedInstructions;
+    /// Program counter of the last VM on this thread which ended with an exception, whatever the mask.
+    static thread_local uint64_t faultPC;
 
 private:
 
@@ -51,6 +73,7 @@ private:
     uint64_t m_io_gas = 0;
     ExtVMFace* m_ext = 0;
     OnOpFunc m_onOp;
+    std::bitset<256> m_hooked;
 
     static std::array<InstructionMetric, 256> c_metrics;
     static void initMetrics();
@@ -77,7 +100,6 @@ private:
     // space for data stack, grows towards smaller addresses from the end
     u256 m_stack[1024];
     u256 *m_stackEnd = &m_stack[1024];
-    size_t stackSize() { return m_stackEnd - m_SP; }
     
 #if EIP_615
     // space for return stack
@@ -131,7 +153,12 @@ private:
     std::vector<uint64_t> m_jumpDests;
     int64_t verifyJumpDest(u256 const& _dest, bool _throw = true);
 
-    void onOperation();
+    void onOperation()
+    {
+        if (m_hooked[static_cast<size_t>(m_OP)])
+            reportOperation();
+    }
+    void reportOperation();
     void adjustStack(unsigned _removed, unsigned _added);
     uint64_t gasForMem(u512 _size);
     void updateSSGas();
@@ -33,7 +33,7 @@ namespace fuzzer {
             || boost::starts_with(snippet, "require")
             || boost::starts_with(snippet, "assert")
           ) {
-            Logger::info("----");
+            LOG_INFO("----");
             for (auto candidate : candidates) {
               if (get<0>(candidate) > offset && get<0>(candidate) + get<1>(candidate) < offset + len) {
                 auto candidateSnippet = contractInfo.source.substr(get<0>(candidate), get<1>(candidate));
@@ -42,14 +42,14 @@ namespace fuzzer {
                       && get<0>(candidate) + get<1>(candidate) <= get<0>(j) + get<1>(j);
                 });
                 if (!numConstant) {
-                  Logger::info(candidateSnippet);
+                  LOG_INFO(candidateSnippet);
                   if (isRuntime) {
                     runtimeJumpis.insert(get<2>(candidate));
-                    Logger::info("pc: " + to_string(get<2>(candidate)));
+                    LOG_INFO("pc: " + to_string(get<2>(candidate)));
                     snippets.insert(make_pair(get<2>(candidate), candidateSnippet));
                   } else {
                     deploymentJumpis.insert(get<2>(candidate));
-                    Logger::info("pc: " + to_string(get<2>(candidate)));
+                    LOG_INFO("pc: " + to_string(get<2>(candidate)));
                     snippets.insert(make_pair(get<2>(candidate), candidateSnippet));
                   }
                 }
@@ -60,14 +60,14 @@ namespace fuzzer {
                      && offset + len <= get<0>(j) + get<1>(j);
             });
             if (!numConstant) {
-              Logger::info(contractInfo.source.substr(offset, len));
+              LOG_INFO(contractInfo.source.substr(offset, len));
               if (isRuntime) {
                 runtimeJumpis.insert(get<0>(opcodes[i]));
-                Logger::info("pc: " + to_string(get<0>(opcodes[i])));
+                LOG_INFO("pc: " + to_string(get<0>(opcodes[i])));
                 snippets.insert(make_pair(get<0>(opcodes[i]), snippet));
               } else {
                 deploymentJumpis.insert(get<0>(opcodes[i]));
-                Logger::info("pc: " + to_string(get<0>(opcodes[i])));
+                LOG_INFO("pc: " + to_string(get<0>(opcodes[i])));
                 snippets.insert(make_pair(get<0>(opcodes[i]), snippet));
               }
             }
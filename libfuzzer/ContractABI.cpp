@@ -1,4 +1,5 @@
 #include <regex>
+#include <map>
 #include "ContractABI.h"
 
 using namespace std;
@@ -276,6 +277,91 @@ namespace fuzzer {
     return ret;
   }
   
+  int ContractABI::walkTestData(bytes const& lens, OnTestValueFunc cb) const {
+    /* Same layout as updateTestData, lens are the first 32 bytes */
+    int lenOffset = 0;
+    int numLens = 0;
+    auto consultRealLen = [&]() {
+      int len = lens[lenOffset];
+      lenOffset = (lenOffset + 1) % 32;
+      numLens ++;
+      return len;
+    };
+    auto consultContainerLen = [](int realLen) {
+      if (!(realLen % 32)) return realLen;
+      return (realLen / 32 + 1) * 32;
+    };
+    auto visit = [&](vector<int> path, bool isDynamic) {
+      int realLen = isDynamic ? consultRealLen() : 32;
+      cb(path, realLen, consultContainerLen(realLen));
+    };
+    for (int fdIdx = 0; fdIdx < (int) fds.size(); fdIdx += 1) {
+      auto const& tds = fds[fdIdx].tds;
+      for (int tdIdx = 0; tdIdx < (int) tds.size(); tdIdx += 1) {
+        auto const& td = tds[tdIdx];
+        switch (td.dimensions.size()) {
+          case 0: {
+            visit({fdIdx, tdIdx, 0, 0}, td.isDynamic);
+            break;
+          }
+          case 1: {
+            int numElem = td.dimensions[0] ? td.dimensions[0] : consultRealLen();
+            for (int i = 0; i < numElem; i += 1) visit({fdIdx, tdIdx, i, 0}, td.isDynamic);
+            break;
+          }
+          case 2: {
+            int numElem = td.dimensions[0] ? td.dimensions[0] : consultRealLen();
+            int numSubElem = td.dimensions[1] ? td.dimensions[1] : consultRealLen();
+            for (int i = 0; i < numElem; i += 1) {
+              for (int j = 0; j < numSubElem; j += 1) visit({fdIdx, tdIdx, i, j}, td.isDynamic);
+            }
+            break;
+          }
+        }
+      }
+    }
+    return numLens;
+  }
+  
+  vector<pair<int, int>> ContractABI::readSlots(bytes const& data) const {
+    vector<pair<int, int>> slots;
+    int offset = 96;
+    auto numLens = walkTestData(bytes(data.begin(), data.begin() + 32), [&](vector<int> const&, int realLen, int containerLen) {
+      if (realLen && offset < (int) data.size()) slots.push_back(make_pair(offset, min(offset + realLen, (int) data.size())));
+      offset += containerLen;
+    });
+    for (int i = 0; i < min(numLens, 32); i += 1) slots.push_back(make_pair(i, i + 1));
+    /* Balance, sender, block number and timestamp */
+    slots.push_back(make_pair(32, 44));
+    slots.push_back(make_pair(44, 64));
+    slots.push_back(make_pair(64, 72));
+    slots.push_back(make_pair(72, 80));
+    sort(slots.begin(), slots.end());
+    return slots;
+  }
+  
+  bytes ContractABI::resizeTestData(bytes const& data, bytes const& lens) const {
+    /* Values of the current layout, bytes past the end read as padding */
+    map<vector<int>, bytes> values;
+    int offset = 96;
+    walkTestData(bytes(data.begin(), data.begin() + 32), [&](vector<int> const& path, int realLen, int containerLen) {
+      bytes d(realLen, 0);
+      for (int i = 0; i < realLen && offset + i < (int) data.size(); i += 1) d[i] = data[offset + i];
+      values[path] = d;
+      offset += containerLen;
+    });
+    bytes newLens(lens.begin(), lens.begin() + 32);
+    bytes ret = newLens;
+    ret.insert(ret.end(), data.begin() + 32, data.begin() + 96);
+    walkTestData(newLens, [&](vector<int> const& path, int realLen, int containerLen) {
+      bytes d(containerLen, 0);
+      auto it = values.find(path);
+      if (it != values.end()) copy_n(it->second.begin(), min(realLen, (int) it->second.size()), d.begin());
+      ret.insert(ret.end(), d.begin(), d.end());
+    });
+    return ret;
+  }
+  
   ContractABI::ContractABI(string abiJson) {
     stringstream ss;
     ss << abiJson;
@@ -316,6 +402,35 @@ namespace fuzzer {
     return bytes(0, 0);
   }
   
+  vector<vector<int>> ContractABI::traceEncoding(bytes const& data) const {
+    /*
+     * Values are copied verbatim, so encode value bytes marked with the low
+     * and high byte of their offset, up to 32K. Lens stay the same, every
+     * other byte of the encoding is the same as with zeroed values
+     */
+    auto encodeAll = [&](function<byte (size_t)> mark) {
+      auto marked = data;
+      for (size_t i = 96; i < marked.size(); i ++) marked[i] = mark(i);
+      ContractABI ca = *this;
+      ca.updateTestData(marked);
+      auto ret = ca.encodeFunctions();
+      ret.insert(ret.begin(), ca.encodeConstructor());
+      return ret;
+    };
+    auto zeros = encodeAll([](size_t) { return 0; });
+    auto lows = encodeAll([](size_t i) { return i & 0xFF; });
+    auto highs = encodeAll([](size_t i) { return (i >> 8) | 0x80; });
+    vector<vector<int>> traces;
+    for (size_t call = 0; call < zeros.size(); call ++) {
+      vector<int> trace(zeros[call].size(), -1);
+      for (size_t i = 0; i < trace.size(); i ++) {
+        if (highs[call][i] != zeros[call][i]) trace[i] = ((highs[call][i] & 0x7F) << 8) | lows[call][i];
+      }
+      traces.push_back(trace);
+    }
+    return traces;
+  }
+
   bool ContractABI::isPayable(string name) {
     for (auto fd : fds) {
       if (fd.name == name) return fd.payable;
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <functional>
 #include "Common.h"
 
 using namespace dev;
@@ -8,6 +9,8 @@ using namespace std;
 namespace fuzzer {
   using Accounts = vector<tuple<bytes, u160, u256, bool>>;
   using FakeBlock = tuple<bytes, int64_t, int64_t>;
+  /* Path (function, argument, element, sub element), real len and container len of a value */
+  using OnTestValueFunc = function<void (vector<int> const& path, int realLen, int containerLen)>;
   
   struct DataType {
     bytes value;
@@ -63,6 +66,17 @@ namespace fuzzer {
       bytes randomTestcase();
       /* Update then call encodeConstructor/encodeFunction to feed to evm */
       void updateTestData(bytes data);
+      /* Walk the values of test data whose dynamic lens are lens, returns how many lens are consulted */
+      int walkTestData(bytes const& lens, OnTestValueFunc cb) const;
+      /* Byte ranges of test data read by updateTestData, one per len, env field or value */
+      vector<pair<int, int>> readSlots(bytes const& data) const;
+      /* Relayout test data for other dynamic lens, values are cut or zero padded */
+      bytes resizeTestData(bytes const& data, bytes const& lens) const;
+      /*
+       * Test data offset of every byte of the encoded constructor, then of
+       * every encoded function, -1 for selectors, headers and padding
+       */
+      vector<vector<int>> traceEncoding(bytes const& data) const;
       /* Standard Json */
       string toStandardJson();
       uint64_t totalFuncs();
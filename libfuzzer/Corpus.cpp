@@ -0,0 +1,185 @@
+#include <sstream>
+#include <queue>
+#include <unordered_map>
+#include <boost/filesystem.hpp>
+#include <libdevcore/CommonIO.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include "Corpus.h"
+
+using namespace dev;
+using namespace std;
+using namespace fuzzer;
+namespace fs = boost::filesystem;
+
+static string INDEX_FILE = "index.txt";
+/* Outdated lines tolerated before the index is rewritten */
+static size_t INDEX_SLACK = 256;
+
+namespace {
+  /* Branch and testcase file of an index line */
+  bool parseLine(string const& line, string &branch, string &fileName) {
+    stringstream ss(line);
+    string comparisonValue, depth, cksum;
+    return (bool) (ss >> branch >> comparisonValue >> depth >> cksum >> fileName);
+  }
+}
+
+bytes Corpus::encode(const FuzzItem &item) {
+  RLPStream s(3);
+  s << item.data;
+  s.appendVector(item.sequence);
+  s << item.depth;
+  return s.out();
+}
+
+FuzzItem Corpus::decode(bytes const& content) {
+  try {
+    RLP rlp(content);
+    if (rlp.isList() && rlp.itemCount() == 3) {
+      FuzzItem item(rlp[0].toBytes(), rlp[1].toVector<uint32_t>());
+      item.depth = rlp[2].toInt<uint64_t>();
+      return item;
+    }
+  } catch (RLPException const&) {}
+  /* Not written by a corpus, take the whole file as test data */
+  return FuzzItem(content);
+}
+
+void Corpus::open(string _folder) {
+  folder = _folder;
+  fs::create_directories(folder);
+  auto indexPath = (fs::path(folder) / INDEX_FILE).string();
+  /* Lines of a resumed run count towards compaction */
+  ifstream previous(indexPath);
+  string line, branch, fileName;
+  while (getline(previous, line)) {
+    if (!parseLine(line, branch, fileName)) continue;
+    if (!latest.count(branch)) branches.push_back(branch);
+    latest[branch] = line;
+    numLines ++;
+  }
+  index.open(indexPath, ios_base::app);
+}
+
+void Corpus::append(string const& branch, string const& line) {
+  index << line << endl;
+  if (!latest.count(branch)) branches.push_back(branch);
+  latest[branch] = line;
+  numLines ++;
+  if (numLines > 2 * branches.size() + INDEX_SLACK) compact();
+}
+
+void Corpus::compact() {
+  auto indexPath = fs::path(folder) / INDEX_FILE;
+  auto tmpPath = fs::path(folder) / (INDEX_FILE + ".tmp");
+  unordered_set<string> referenced;
+  {
+    ofstream out(tmpPath.string(), ios_base::trunc);
+    string branch, fileName;
+    for (auto const& it : branches) {
+      out << latest[it] << endl;
+      if (parseLine(latest[it], branch, fileName)) referenced.insert(fileName);
+    }
+  }
+  /* A killed run finds either the old or the new index */
+  index.close();
+  fs::rename(tmpPath, indexPath);
+  index.open(indexPath.string(), ios_base::app);
+  numLines = branches.size();
+  for (auto it = written.begin(); it != written.end();) {
+    auto fileName = it->hex() + ".bin";
+    if (referenced.count(fileName)) {
+      it ++;
+      continue;
+    }
+    boost::system::error_code ec;
+    fs::remove(fs::path(folder) / fileName, ec);
+    it = written.erase(it);
+  }
+}
+
+string Corpus::write(const FuzzItem &item) {
+  auto content = encode(item);
+  auto hash = sha3(content);
+  auto fileName = hash.hex() + ".bin";
+  if (written.insert(hash).second) {
+    writeFile(fs::path(folder) / fileName, content, true);
+  }
+  return fileName;
+}
+
+void Corpus::save(BranchId branchId, const FuzzItem &item, u256 const& comparisonValue) {
+  if (!isOpen()) return;
+  auto fileName = write(item);
+  auto branch = branchToString(branchId);
+  stringstream line;
+  line << branch << " " << comparisonValue << " " << item.depth << " " << item.res.cksum << " " << fileName;
+  append(branch, line.str());
+}
+
+vector<FuzzItem> Corpus::load(string folder) {
+  vector<FuzzItem> items;
+  ifstream index((fs::path(folder) / INDEX_FILE).string());
+  if (!index.is_open()) return items;
+  /* Later lines replace earlier leaders of the same branch */
+  unordered_map<string, string> latest;
+  vector<string> branches;
+  string line;
+  while (getline(index, line)) {
+    string branch, fileName;
+    if (!parseLine(line, branch, fileName)) continue;
+    if (!latest.count(branch)) branches.push_back(branch);
+    latest[branch] = fileName;
+  }
+  unordered_set<string> loaded;
+  for (auto const& branch : branches) {
+    auto fileName = latest[branch];
+    auto filePath = fs::path(folder) / fileName;
+    if (!loaded.insert(fileName).second || !fs::exists(filePath)) continue;
+    items.push_back(decode(contents(filePath)));
+  }
+  return items;
+}
+
+vector<FuzzItem> Corpus::loadSeeds(string folder) {
+  vector<FuzzItem> items;
+  if (!fs::is_directory(folder)) return items;
+  for (auto const& file : fs::directory_iterator(folder)) {
+    if (!fs::is_regular_file(file.status()) || file.path().filename() == INDEX_FILE) continue;
+    auto content = contents(file.path());
+    if (content.size()) items.push_back(decode(content));
+  }
+  return items;
+}
+
+vector<pair<size_t, vector<uint64_t>>> Corpus::cover(const vector<vector<uint64_t>> &features, const vector<double> &costs) {
+  vector<pair<size_t, vector<uint64_t>>> chosen;
+  unordered_set<uint64_t> covered;
+  auto uncovered = [&](size_t idx) -> vector<uint64_t> {
+    vector<uint64_t> ret;
+    for (auto feature : features[idx]) {
+      if (!covered.count(feature)) ret.push_back(feature);
+    }
+    return ret;
+  };
+  /* Scores only drop as features get covered, so stale entries are rescored lazily */
+  priority_queue<pair<double, size_t>> candidates;
+  for (size_t i = 0; i < features.size(); i ++) {
+    if (features[i].size()) candidates.push(make_pair(features[i].size() / costs[i], i));
+  }
+  while (!candidates.empty()) {
+    auto top = candidates.top();
+    candidates.pop();
+    auto news = uncovered(top.second);
+    if (news.empty()) continue;
+    auto score = news.size() / costs[top.second];
+    if (!candidates.empty() && score < candidates.top().first) {
+      candidates.push(make_pair(score, top.second));
+      continue;
+    }
+    for (auto feature : news) covered.insert(feature);
+    chosen.push_back(make_pair(top.second, news));
+  }
+  return chosen;
+}
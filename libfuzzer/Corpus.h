@@ -0,0 +1,51 @@
+#pragma once
+#include <fstream>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "CoverageMap.h"
+#include "FuzzItem.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  /*
+   * On-disk corpus of a contract. Every leader testcase is stored once as
+   * <sha3>.bin, and index.txt appends one line per leader change:
+   * branch, comparison value, depth, cksum and testcase file. Both are written
+   * as soon as the frontier changes so that a killed run keeps its progress.
+   * Once most lines are outdated the index is rewritten with the latest line
+   * of every branch, and the testcases no line names anymore are removed.
+   */
+  class Corpus {
+    string folder;
+    ofstream index;
+    unordered_set<h256> written;
+    /* Latest line of every branch, branches in the order they first appeared */
+    unordered_map<string, string> latest;
+    vector<string> branches;
+    size_t numLines = 0;
+    void append(string const& branch, string const& line);
+    void compact();
+    public:
+      /* Creates the folder if needed, appends to an existing index */
+      void open(string folder);
+      bool isOpen() const { return index.is_open(); }
+      void save(BranchId branchId, const FuzzItem &item, u256 const& comparisonValue);
+      /* Stores the testcase without indexing it, returns its file name */
+      string write(const FuzzItem &item);
+      /* Latest testcase of every branch in the index, each testcase once */
+      static vector<FuzzItem> load(string folder);
+      /* Every file of a folder, either a corpus testcase or raw test data */
+      static vector<FuzzItem> loadSeeds(string folder);
+      static bytes encode(const FuzzItem &item);
+      static FuzzItem decode(bytes const& content);
+      /*
+       * Greedy weighted set cover: features[i] lists the features input i
+       * reaches, costs[i] its weight. Returns the chosen inputs, each one with
+       * the features it was the first to cover.
+       */
+      static vector<pair<size_t, vector<uint64_t>>> cover(const vector<vector<uint64_t>> &features, const vector<double> &costs);
+  };
+}
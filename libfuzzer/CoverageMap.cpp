@@ -0,0 +1,72 @@
+#include "CoverageMap.h"
+
+namespace fuzzer {
+  static uint32_t COVERAGE_MAP_SIZE = 1 << 14;
+
+  string branchToString(BranchId id) {
+    return to_string(branchFrom(id)) + ":" + to_string(branchTo(id));
+  }
+
+  CoverageMap::CoverageMap(): slots(COVERAGE_MAP_SIZE, 0) {
+    usedSlots.reserve(COVERAGE_MAP_SIZE / 2);
+    branches.reserve(COVERAGE_MAP_SIZE / 2);
+    values.reserve(COVERAGE_MAP_SIZE / 2);
+  }
+
+  /* Slot holding id, or the empty slot where it belongs */
+  uint32_t CoverageMap::find(BranchId id) {
+    uint32_t mask = slots.size() - 1;
+    uint32_t pos = (uint32_t)((id * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (slots[pos] && branches[slots[pos] - 1] != id) pos = (pos + 1) & mask;
+    return pos;
+  }
+
+  /* Keep load factor under 1/2, only happens on very large contracts */
+  void CoverageMap::grow() {
+    slots.assign(slots.size() * 2, 0);
+    usedSlots.clear();
+    for (uint32_t i = 0; i < branches.size(); i ++) {
+      auto pos = find(branches[i]);
+      slots[pos] = i + 1;
+      usedSlots.push_back(pos);
+    }
+  }
+
+  bool CoverageMap::record(BranchId id) {
+    auto pos = find(id);
+    if (slots[pos]) return false;
+    branches.push_back(id);
+    values.push_back(0);
+    slots[pos] = branches.size();
+    usedSlots.push_back(pos);
+    if (branches.size() * 2 > slots.size()) grow();
+    return true;
+  }
+
+  bool CoverageMap::record(BranchId id, u256 const& value) {
+    auto pos = find(id);
+    if (slots[pos]) {
+      values[slots[pos] - 1] = value;
+      return false;
+    }
+    record(id);
+    values.back() = value;
+    return true;
+  }
+
+  void CoverageMap::clear() {
+    for (auto pos : usedSlots) slots[pos] = 0;
+    usedSlots.clear();
+    branches.clear();
+    values.clear();
+  }
+
+  vector<pair<BranchId, u256>> CoverageMap::hitsWithValues() const {
+    vector<pair<BranchId, u256>> ret;
+    ret.reserve(branches.size());
+    for (uint32_t i = 0; i < branches.size(); i ++) {
+      ret.push_back(make_pair(branches[i], values[i]));
+    }
+    return ret;
+  }
+}
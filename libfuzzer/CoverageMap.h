@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "Common.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  /* Edge from a JUMPI to its destination, packed as (from << 32 | to) */
+  using BranchId = uint64_t;
+  inline BranchId toBranchId(uint64_t from, uint64_t to) {
+    return from << 32 | (to & 0xFFFFFFFF);
+  }
+  inline uint64_t branchFrom(BranchId id) { return id >> 32; }
+  inline uint64_t branchTo(BranchId id) { return id & 0xFFFFFFFF; }
+  /* Only used when reporting */
+  string branchToString(BranchId id);
+  /* Roll a newly hit edge into the path hash of an execution */
+  inline uint64_t hashBranch(uint64_t hash, BranchId id) {
+    id *= 0x9E3779B97F4A7C15ULL;
+    id ^= id >> 29;
+    return ((hash << 7) | (hash >> 57)) ^ id;
+  }
+  /*
+   * Edges hit during one execution. Open addressing over a fixed size slot
+   * table, branches are kept in order of first hit. Once warmed up, neither
+   * recording nor clearing allocates
+   */
+  class CoverageMap {
+    /* Index + 1 into branches, 0 means empty */
+    vector<uint32_t> slots;
+    vector<uint32_t> usedSlots;
+    vector<BranchId> branches;
+    vector<u256> values;
+    uint32_t find(BranchId id);
+    void grow();
+    public:
+      CoverageMap();
+      /* Record an edge, returns true if it is the first hit */
+      bool record(BranchId id);
+      /* Record an edge with a value, the latest value wins */
+      bool record(BranchId id, u256 const& value);
+      void clear();
+      uint64_t size() const { return branches.size(); }
+      vector<BranchId> const& hits() const { return branches; }
+      vector<pair<BranchId, u256>> hitsWithValues() const;
+  };
+}
@@ -1,4 +1,5 @@
 #include <set>
+#include <libdevcore/SHA3.h>
 #include "Dictionary.h"
 
 using namespace std;
@@ -37,4 +38,67 @@ namespace fuzzer {
       extras.push_back(d);
     }
   }
+
+  /* Entries with finds rank above untried ones, which rank above the ones used in vain */
+  size_t RuntimeDictionary::victim() const {
+    size_t ret = 0;
+    auto score = [&](size_t idx) -> double {
+      auto const& extra = entries[idx].extra;
+      if (extra.finds) return 1 + (double) extra.finds / extra.uses;
+      return 1.0 / (extra.uses + 1);
+    };
+    for (size_t i = 1; i < entries.size(); i ++) {
+      auto better = score(ret) - score(i);
+      if (better > 0 || (better == 0 && entries[i].added < entries[ret].added)) ret = i;
+    }
+    return ret;
+  }
+
+  void RuntimeDictionary::add(const vector<bytes> &values) {
+    if (!capacity) return;
+    Guard l(x_entries);
+    for (auto const& value : values) {
+      auto key = sha3(value);
+      if (positions.count(key)) continue;
+      Entry entry;
+      entry.extra.data = value;
+      entry.added = numAdded ++;
+      if (entries.size() < capacity) {
+        positions[key] = entries.size();
+        entries.push_back(entry);
+        continue;
+      }
+      auto idx = victim();
+      positions.erase(sha3(entries[idx].extra.data));
+      positions[key] = idx;
+      entries[idx] = entry;
+    }
+  }
+
+  void RuntimeDictionary::credit(const Dictionary &used) {
+    Guard l(x_entries);
+    for (auto const& extra : used.extras) {
+      if (!extra.uses) continue;
+      auto it = positions.find(sha3(extra.data));
+      if (it == positions.end()) continue;
+      entries[it->second].extra.uses += extra.uses;
+      entries[it->second].extra.finds += extra.finds;
+    }
+  }
+
+  Dictionary RuntimeDictionary::snapshot() const {
+    Dictionary dict;
+    Guard l(x_entries);
+    for (auto const& entry : entries) {
+      ExtraData d;
+      d.data = entry.extra.data;
+      dict.extras.push_back(d);
+    }
+    return dict;
+  }
+
+  size_t RuntimeDictionary::size() const {
+    Guard l(x_entries);
+    return entries.size();
+  }
 }
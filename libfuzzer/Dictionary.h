@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include <unordered_map>
+#include <libdevcore/Guards.h>
 #include "Common.h"
 #include "Util.h"
 
@@ -17,4 +19,29 @@ namespace fuzzer {
       void fromCode(bytes code);
       void fromAddress(bytes address);
   };
+  /*
+   * Values the contract computed at runtime, shared by the workers. Entries
+   * are distinct and bounded, once full the least useful entry is evicted:
+   * used often without finds first, then untried, the oldest among equals
+   */
+  class RuntimeDictionary {
+    struct Entry {
+      ExtraData extra;
+      uint64_t added;
+    };
+    size_t capacity;
+    uint64_t numAdded = 0;
+    vector<Entry> entries;
+    unordered_map<h256, size_t> positions;
+    mutable Mutex x_entries;
+    size_t victim() const;
+    public:
+      RuntimeDictionary(size_t capacity = RUNTIME_DICT_MAX): capacity(capacity) {}
+      void add(const vector<bytes> &values);
+      /* Add the uses and finds counted on a snapshot, evicted values are ignored */
+      void credit(const Dictionary &used);
+      /* Copy of the entries, its statistics start at zero and are credited back */
+      Dictionary snapshot() const;
+      size_t size() const;
+  };
 }
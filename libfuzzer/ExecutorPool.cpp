@@ -0,0 +1,128 @@
+#include "ExecutorPool.h"
+
+using namespace dev;
+using namespace std;
+using namespace fuzzer;
+
+void Batch::push(bytes const& data, Sequence const& sequence) {
+  auto &item = items[size];
+  /* Assign keeps the capacity of the slot */
+  item.data.assign(data.begin(), data.end());
+  item.sequence.assign(sequence.begin(), sequence.end());
+  item.eff.clear();
+  item.depth = 0;
+  size ++;
+}
+
+void CompletionQueue::push(BatchPtr batch) {
+  /* Notify under the lock, the producer may destroy the queue once it pops */
+  Guard l(x_done);
+  done.push_back(move(batch));
+  ready.notify_one();
+}
+
+BatchPtr CompletionQueue::pop() {
+  UniqueGuard l(x_done);
+  ready.wait(l, [&]() { return !done.empty(); });
+  auto batch = move(done.front());
+  done.pop_front();
+  return batch;
+}
+
+ExecutorPool::ExecutorPool(unsigned numThreads, function<OnBatchFunc ()> makeExecutor) {
+  for (unsigned i = 0; i < max(numThreads, 1u); i ++) {
+    threads.push_back(thread([this, makeExecutor]() {
+      auto execute = makeExecutor();
+      while (true) {
+        BatchPtr batch;
+        {
+          UniqueGuard l(x_jobs);
+          ready.wait(l, [&]() { return stopping || !jobs.empty(); });
+          if (jobs.empty()) break;
+          batch = move(jobs.front());
+          jobs.pop_front();
+        }
+        execute(*batch);
+        auto completions = batch->completions;
+        completions->push(move(batch));
+      }
+      Batch last(0);
+      execute(last);
+    }));
+  }
+}
+
+void ExecutorPool::submit(BatchPtr batch) {
+  {
+    Guard l(x_jobs);
+    jobs.push_back(move(batch));
+  }
+  ready.notify_one();
+}
+
+void ExecutorPool::stop() {
+  {
+    Guard l(x_jobs);
+    stopping = true;
+  }
+  ready.notify_all();
+  for (auto &t : threads) t.join();
+  threads.clear();
+}
+
+BatchQueue::BatchQueue(ExecutorPool &pool, OnBatchFunc merge, size_t batchSize, size_t depth): pool(pool), merge(merge) {
+  for (size_t i = 0; i < max(depth, (size_t) 1); i ++) {
+    spare.push_back(BatchPtr(new Batch(batchSize)));
+    spare.back()->completions = &completions;
+  }
+  current = move(spare.back());
+  spare.pop_back();
+}
+
+void BatchQueue::submit() {
+  inFlight ++;
+  pool.submit(move(current));
+  /* Every buffer is in flight, wait for the oldest one */
+  if (spare.empty()) complete();
+  current = move(spare.back());
+  spare.pop_back();
+}
+
+void BatchQueue::complete() {
+  auto batch = completions.pop();
+  inFlight --;
+  /* The buffer is reused even if merge unwinds */
+  try {
+    merge(*batch);
+  } catch (...) {
+    batch->size = 0;
+    spare.push_back(move(batch));
+    throw;
+  }
+  batch->size = 0;
+  spare.push_back(move(batch));
+}
+
+void BatchQueue::push(bytes const& data, Sequence const& sequence) {
+  current->push(data, sequence);
+  if (current->full()) submit();
+}
+
+void BatchQueue::flush() {
+  if (current->size) submit();
+  while (inFlight) complete();
+}
+
+void BatchQueue::cancel() {
+  while (inFlight) {
+    auto batch = completions.pop();
+    inFlight --;
+    batch->size = 0;
+    spare.push_back(move(batch));
+  }
+  if (!current) {
+    current = move(spare.back());
+    spare.pop_back();
+  }
+  current->size = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <libdevcore/Guards.h>
+#include "Util.h"
+#include "FuzzItem.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  class CompletionQueue;
+  /* Candidates executed together, slots keep their buffers across batches */
+  struct Batch {
+    vector<FuzzItem> items;
+    /* Execution time of every item in microseconds */
+    vector<double> execCosts;
+    size_t size = 0;
+    /* Where the executor hands the batch back */
+    CompletionQueue *completions = nullptr;
+    Batch(size_t capacity): items(capacity, FuzzItem(bytes())), execCosts(capacity, 0) {}
+    bool full() const { return size == items.size(); }
+    void push(bytes const& data, Sequence const& sequence);
+  };
+  using BatchPtr = unique_ptr<Batch>;
+  using OnBatchFunc = function<void (Batch &)>;
+  /* Executed batches of one producer, in completion order */
+  class CompletionQueue {
+    Mutex x_done;
+    condition_variable ready;
+    deque<BatchPtr> done;
+    public:
+      void push(BatchPtr batch);
+      /* Blocks until a batch is done */
+      BatchPtr pop();
+  };
+  /*
+   * Threads executing the batches of every producer. Each thread builds its
+   * own executor, so that executions share nothing, and passes it an empty
+   * batch once before exiting.
+   */
+  class ExecutorPool {
+    Mutex x_jobs;
+    condition_variable ready;
+    deque<BatchPtr> jobs;
+    bool stopping = false;
+    vector<thread> threads;
+    public:
+      ExecutorPool(unsigned numThreads, function<OnBatchFunc ()> makeExecutor);
+      ~ExecutorPool() { stop(); }
+      void submit(BatchPtr batch);
+      /* Executes the queued batches, then joins the threads */
+      void stop();
+  };
+  /*
+   * Producer side of the pool. Candidates fill a preallocated batch which is
+   * submitted once full, the next one is generated while it executes. At
+   * most depth batches are in flight, executed ones are given to merge.
+   */
+  class BatchQueue {
+    ExecutorPool &pool;
+    OnBatchFunc merge;
+    CompletionQueue completions;
+    vector<BatchPtr> spare;
+    BatchPtr current;
+    size_t inFlight = 0;
+    void submit();
+    void complete();
+    public:
+      BatchQueue(ExecutorPool &pool, OnBatchFunc merge, size_t batchSize = BATCH_SIZE, size_t depth = BATCH_DEPTH);
+      ~BatchQueue() { cancel(); }
+      void push(bytes const& data, Sequence const& sequence);
+      /* Submits the partial batch and merges every batch in flight */
+      void flush();
+      /* Waits for the batches in flight without merging them */
+      void cancel();
+  };
+}
@@ -0,0 +1,66 @@
+#include "Frontier.h"
+
+using namespace dev;
+using namespace std;
+using namespace fuzzer;
+
+void Frontier::enqueue(BranchId branchId) {
+  if (queued.insert(make_pair(branchId, queue.size())).second) queue.push_back(branchId);
+}
+
+FuzzItem Leader::load() const {
+  auto ret = item->toItem();
+  ret.fuzzedCount = fuzzedCount;
+  ret.eff = eff;
+  return ret;
+}
+
+Leader &Frontier::setLeader(BranchId branchId, const Leader &leader) {
+  auto it = leaders.find(branchId);
+  fresh ++;
+  if (it != leaders.end()) {
+    if (!it->second.fuzzedCount) fresh --;
+    it->second = leader;
+    return it->second;
+  }
+  return leaders.insert(make_pair(branchId, leader)).first->second;
+}
+
+Leader *Frontier::findLeader(BranchId branchId) {
+  auto it = leaders.find(branchId);
+  return it == leaders.end() ? nullptr : &it->second;
+}
+
+Leader &Frontier::cover(BranchId branchId, TestcaseRef item) {
+  tracebits.insert(branchId);
+  /* Remove the covered predicate right away instead of sweeping all of them */
+  predicates.erase(branchId);
+  enqueue(branchId);
+  return setLeader(branchId, Leader(item, 0));
+}
+
+Leader &Frontier::approach(BranchId branchId, TestcaseRef item, u256 comparisonValue) {
+  auto &branchStats = stats[branchId];
+  if (!branchStats.initialValue) branchStats.initialValue = comparisonValue;
+  if (!tracebits.count(branchId)) predicates.insert(branchId);
+  enqueue(branchId);
+  return setLeader(branchId, Leader(item, comparisonValue));
+}
+
+void Frontier::relocate(const unordered_map<const Testcase *, TestcaseRef> &moved) {
+  if (moved.empty()) return;
+  for (auto &it : leaders) {
+    auto copy = moved.find(it.second.item.get());
+    if (copy != moved.end()) it.second.item = copy->second;
+  }
+}
+
+void Frontier::markFuzzed(BranchId branchId) {
+  auto leader = findLeader(branchId);
+  if (leader && !leader->fuzzedCount ++) fresh --;
+}
+
+void Frontier::hit(BranchId branchId) {
+  stats[branchId].hits ++;
+  totalHits ++;
+}
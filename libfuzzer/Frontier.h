@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "CoverageMap.h"
+#include "FuzzItem.h"
+#include "TestcaseStore.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  struct Leader {
+    TestcaseRef item;
+    u256 comparisonValue = 0;
+    uint64_t fuzzedCount = 0;
+    /* Effector map learnt by its deterministic stages, empty until then */
+    bytes eff;
+    Leader(TestcaseRef _item, u256 _comparisionValue): item(_item) {
+      comparisonValue = _comparisionValue;
+    }
+    /* Mutable copy of the testcase to fuzz */
+    FuzzItem load() const;
+  };
+  /* Running stats of a branch, kept when its leader is replaced */
+  struct BranchStats {
+    /* Executions reaching the branch without taking it */
+    uint64_t hits = 0;
+    /* Times its leader was picked */
+    uint64_t selected = 0;
+    /* Execution time of the leader in microseconds */
+    double execCost = 0;
+    /* Comparison value of the first leader */
+    u256 initialValue = 0;
+  };
+  /*
+   * Coverage frontier: covered branches, uncovered predicates, the best
+   * test case (leader) of each branch and the queue to fuzz them in.
+   * Every operation is a hashed lookup, so the bookkeeping cost of one
+   * execution does not grow with the number of known branches.
+   */
+  class Frontier {
+    unordered_set<BranchId> tracebits;
+    unordered_set<BranchId> predicates;
+    unordered_map<BranchId, Leader> leaders;
+    vector<BranchId> queue;
+    /* Position of every queued branch */
+    unordered_map<BranchId, size_t> queued;
+    unordered_map<BranchId, BranchStats> stats;
+    uint64_t totalHits = 0;
+    /* Leaders never fuzzed */
+    size_t fresh = 0;
+    void enqueue(BranchId branchId);
+    Leader &setLeader(BranchId branchId, const Leader &leader);
+    public:
+      bool isCovered(BranchId branchId) const { return tracebits.count(branchId); }
+      /* Leader of a branch or nullptr, valid until the branch gets a new leader */
+      Leader *findLeader(BranchId branchId);
+      /* Branch is taken, item becomes its leader and predicate is dropped */
+      Leader &cover(BranchId branchId, TestcaseRef item);
+      /* Branch is not taken yet, item is the closest one with given distance */
+      Leader &approach(BranchId branchId, TestcaseRef item, u256 comparisonValue);
+      /* Swap the leaders for the copies made by TestcaseStore::compact */
+      void relocate(const unordered_map<const Testcase *, TestcaseRef> &moved);
+      /* A fuzzing cycle of the leader is done */
+      void markFuzzed(BranchId branchId);
+      /* An execution reached the predicate of an uncovered branch */
+      void hit(BranchId branchId);
+      BranchStats &getStats(BranchId branchId) { return stats[branchId]; }
+      double averageHits() const { return stats.size() ? (double) totalHits / stats.size() : 0; }
+      size_t numCovered() const { return tracebits.size(); }
+      size_t numPredicates() const { return predicates.size(); }
+      size_t numFresh() const { return fresh; }
+      const unordered_map<BranchId, Leader> &getLeaders() const { return leaders; }
+      const vector<BranchId> &getQueue() const { return queue; }
+      /* Position of the branch in the queue, the queue size if it is not queued */
+      size_t queuePosition(BranchId branchId) const {
+        auto it = queued.find(branchId);
+        return it == queued.end() ? queue.size() : it->second;
+      }
+  };
+}
@@ -1,5 +1,6 @@
 #pragma once
-#include "TargetContainer.h"
+#include <functional>
+#include "TargetContainerResult.h"
 #include "Common.h"
 
 using namespace std;
@@ -7,14 +8,21 @@ using namespace dev;
 using namespace eth;
 
 namespace fuzzer {
+  /* Indexes of the functions to call in order, empty to call every function once */
+  using Sequence = vector<uint32_t>;
   struct FuzzItem {
     bytes data;
+    Sequence sequence;
     TargetContainerResult res;
     uint64_t fuzzedCount = 0;
     uint64_t depth = 0;
-    FuzzItem(bytes _data) {
+    /* Effector map learnt by its deterministic stages, empty until then */
+    bytes eff;
+    FuzzItem(bytes _data, Sequence _sequence = Sequence()) {
       data = _data;
+      sequence = _sequence;
     }
   };
   using OnMutateFunc = function<FuzzItem (bytes b)>;
+  using OnMutateSequenceFunc = function<FuzzItem (Sequence s)>;
 }
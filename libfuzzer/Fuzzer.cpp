@@ -1,4 +1,8 @@
 #include <fstream>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <libdevcore/CommonIO.h>
 #include "Fuzzer.h"
 #include "Mutation.h"
 #include "Util.h"
@@ -13,33 +17,25 @@ using namespace std;
 using namespace fuzzer;
 namespace pt = boost::property_tree;
 
-/* Setup virgin byte to 255 */
-Fuzzer::Fuzzer(FuzzParam fuzzParam): fuzzParam(fuzzParam){
-  fill_n(fuzzStat.stageFinds, 32, 0);
+namespace {
+  /* Thrown from the save callback to unwind a worker out of its mutation stage */
+  struct FuzzStopped {};
 }
 
-/* Detect new exception */
-void Fuzzer::updateExceptions(unordered_set<string> exps) {
-  for (auto it: exps) uniqExceptions.insert(it);
+/* Setup virgin byte to 255 */
+Fuzzer::Fuzzer(FuzzParam fuzzParam): vulnerabilities(0), fuzzParam(fuzzParam), stopped(false), progressWanted(false) {
+  fill_n(fuzzStat.stageFinds, 32, 0);
 }
 
-/* Detect new bits by comparing tracebits to virginbits */
-void Fuzzer::updateTracebits(unordered_set<string> _tracebits) {
-  for (auto it: _tracebits) tracebits.insert(it);
+/* Merge oracle results found by one of the workers, most executions find nothing new */
+void Fuzzer::updateVulnerabilities(Findings const& findings) {
+  auto bits = findings.to_ulong();
+  if (bits & ~vulnerabilities.load(memory_order_relaxed)) vulnerabilities.fetch_or(bits, memory_order_relaxed);
 }
 
-void Fuzzer::updatePredicates(unordered_map<string, u256> _pred) {
-  for (auto it : _pred) {
-    predicates.insert(it.first);
-  };
-  // Remove covered predicates
-  for(auto it = predicates.begin(); it != predicates.end(); ) {
-    if (tracebits.count(*it)) {
-      it = predicates.erase(it);
-    } else {
-      ++it;
-    }
-  }
+/* Detect new exception */
+void Fuzzer::updateExceptions(const unordered_set<uint64_t> &exps) {
+  for (auto it: exps) uniqExceptions.insert(it);
 }
 
 ContractInfo Fuzzer::mainContract() {
@@ -51,8 +47,15 @@ ContractInfo Fuzzer::mainContract() {
   return *it;
 }
 
-void Fuzzer::showStats(const Mutation &mutation, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>> &validJumpis) {
+void Fuzzer::showStats(const ValidJumpis &validJumpis) {
   int numLines = 24, i = 0;
+  StageProgress stage;
+  {
+    Guard l(x_progress);
+    stage = progress;
+  }
+  auto numLeaders = fuzzStat.numLeaders.load(memory_order_relaxed);
+  Findings vulnerabilities(this->vulnerabilities.load(memory_order_relaxed));
   if (!fuzzStat.clearScreen) {
     for (i = 0; i < numLines; i++) cout << endl;
     fuzzStat.clearScreen = true;
@@ -60,47 +63,48 @@ void Fuzzer::showStats(const Mutation &mutation, const tuple<unordered_set<uint6
   double duration = timer.elapsed();
   double fromLastNewPath = timer.elapsed() - fuzzStat.lastNewPath;
   for (i = 0; i < numLines; i++) cout << "\x1b[A";
-  auto nowTrying = padStr(mutation.stageName, 20);
-  auto stageExecProgress = to_string(mutation.stageCur) + "/" + to_string(mutation.stageMax);
-  auto stageExecPercentage = mutation.stageMax == 0 ? to_string(100) : to_string((uint64_t)((float) (mutation.stageCur) / mutation.stageMax * 100));
+  auto nowTrying = padStr(stage.stageName, 20);
+  auto stageExecProgress = to_string(stage.stageCur) + "/" + to_string(stage.stageMax);
+  auto stageExecPercentage = stage.stageMax == 0 ? to_string(100) : to_string((uint64_t)((float) (stage.stageCur) / stage.stageMax * 100));
   auto stageExec = padStr(stageExecProgress + " (" + stageExecPercentage + "%)", 20);
   auto allExecs = padStr(to_string(fuzzStat.totalExecs), 20);
   auto execSpeed = padStr(to_string((int)(fuzzStat.totalExecs / duration)), 20);
-  auto cyclePercentage = (uint64_t)((float)(fuzzStat.idx + 1) / leaders.size() * 100);
+  auto cyclePercentage = (uint64_t)((float)(fuzzStat.idx + 1) / numLeaders * 100);
   auto cycleProgress = padStr(to_string(fuzzStat.idx + 1) + " (" + to_string(cyclePercentage) + "%)", 20);
   auto cycleDone = padStr(to_string(fuzzStat.queueCycle), 15);
   auto totalBranches = (get<0>(validJumpis).size() + get<1>(validJumpis).size()) * 2;
   auto numBranches = padStr(to_string(totalBranches), 15);
-  auto coverage = padStr(to_string((uint64_t)((float) tracebits.size() / (float) totalBranches * 100)) + "%", 15);
-  auto flip1 = to_string(fuzzStat.stageFinds[STAGE_FLIP1]) + "/" + to_string(mutation.stageCycles[STAGE_FLIP1]);
-  auto flip2 = to_string(fuzzStat.stageFinds[STAGE_FLIP2]) + "/" + to_string(mutation.stageCycles[STAGE_FLIP2]);
-  auto flip4 = to_string(fuzzStat.stageFinds[STAGE_FLIP4]) + "/" + to_string(mutation.stageCycles[STAGE_FLIP4]);
+  auto coverage = padStr(to_string((uint64_t)((float) fuzzStat.numCovered / (float) totalBranches * 100)) + "%", 15);
+  auto flip1 = to_string(fuzzStat.stageFinds[STAGE_FLIP1]) + "/" + to_string(Mutation::stageCycles[STAGE_FLIP1]);
+  auto flip2 = to_string(fuzzStat.stageFinds[STAGE_FLIP2]) + "/" + to_string(Mutation::stageCycles[STAGE_FLIP2]);
+  auto flip4 = to_string(fuzzStat.stageFinds[STAGE_FLIP4]) + "/" + to_string(Mutation::stageCycles[STAGE_FLIP4]);
   auto bitflip = padStr(flip1 + ", " + flip2 + ", " + flip4, 30);
-  auto byte1 = to_string(fuzzStat.stageFinds[STAGE_FLIP8]) + "/" + to_string(mutation.stageCycles[STAGE_FLIP8]);
-  auto byte2 = to_string(fuzzStat.stageFinds[STAGE_FLIP16]) + "/" + to_string(mutation.stageCycles[STAGE_FLIP16]);
-  auto byte4 = to_string(fuzzStat.stageFinds[STAGE_FLIP32]) + "/" + to_string(mutation.stageCycles[STAGE_FLIP32]);
+  auto byte1 = to_string(fuzzStat.stageFinds[STAGE_FLIP8]) + "/" + to_string(Mutation::stageCycles[STAGE_FLIP8]);
+  auto byte2 = to_string(fuzzStat.stageFinds[STAGE_FLIP16]) + "/" + to_string(Mutation::stageCycles[STAGE_FLIP16]);
+  auto byte4 = to_string(fuzzStat.stageFinds[STAGE_FLIP32]) + "/" + to_string(Mutation::stageCycles[STAGE_FLIP32]);
   auto byteflip = padStr(byte1 + ", " + byte2 + ", " + byte4, 30);
-  auto arith1 = to_string(fuzzStat.stageFinds[STAGE_ARITH8]) + "/" + to_string(mutation.stageCycles[STAGE_ARITH8]);
-  auto arith2 = to_string(fuzzStat.stageFinds[STAGE_ARITH16]) + "/" + to_string(mutation.stageCycles[STAGE_ARITH16]);
-  auto arith4 = to_string(fuzzStat.stageFinds[STAGE_ARITH32]) + "/" + to_string(mutation.stageCycles[STAGE_ARITH32]);
-  auto arithmetic = padStr(arith1 + ", " + arith2 + ", " + arith4, 30);
-  auto int1 = to_string(fuzzStat.stageFinds[STAGE_INTEREST8]) + "/" + to_string(mutation.stageCycles[STAGE_INTEREST8]);
-  auto int2 = to_string(fuzzStat.stageFinds[STAGE_INTEREST16]) + "/" + to_string(mutation.stageCycles[STAGE_INTEREST16]);
-  auto int4 = to_string(fuzzStat.stageFinds[STAGE_INTEREST32]) + "/" + to_string(mutation.stageCycles[STAGE_INTEREST32]);
+  auto arith1 = to_string(fuzzStat.stageFinds[STAGE_ARITH8]) + "/" + to_string(Mutation::stageCycles[STAGE_ARITH8]);
+  auto arith2 = to_string(fuzzStat.stageFinds[STAGE_ARITH16]) + "/" + to_string(Mutation::stageCycles[STAGE_ARITH16]);
+  auto arith4 = to_string(fuzzStat.stageFinds[STAGE_ARITH32]) + "/" + to_string(Mutation::stageCycles[STAGE_ARITH32]);
+  auto search = to_string(fuzzStat.stageFinds[STAGE_SEARCH]) + "/" + to_string(Mutation::stageCycles[STAGE_SEARCH]);
+  auto arithmetic = padStr(arith1 + ", " + arith2 + ", " + arith4 + ", " + search, 30);
+  auto int1 = to_string(fuzzStat.stageFinds[STAGE_INTEREST8]) + "/" + to_string(Mutation::stageCycles[STAGE_INTEREST8]);
+  auto int2 = to_string(fuzzStat.stageFinds[STAGE_INTEREST16]) + "/" + to_string(Mutation::stageCycles[STAGE_INTEREST16]);
+  auto int4 = to_string(fuzzStat.stageFinds[STAGE_INTEREST32]) + "/" + to_string(Mutation::stageCycles[STAGE_INTEREST32]);
   auto knownInts = padStr(int1 + ", " + int2 + ", " + int4, 30);
-  auto addrDict1 = to_string(fuzzStat.stageFinds[STAGE_EXTRAS_AO]) + "/" + to_string(mutation.stageCycles[STAGE_EXTRAS_AO]);
-  auto dict1 = to_string(fuzzStat.stageFinds[STAGE_EXTRAS_UO]) + "/" + to_string(mutation.stageCycles[STAGE_EXTRAS_UO]);
-  auto dictionary = padStr(dict1 + ", " + addrDict1, 30);
-  auto hav1 = to_string(fuzzStat.stageFinds[STAGE_HAVOC]) + "/" + to_string(mutation.stageCycles[STAGE_HAVOC]);
-  auto havoc = padStr(hav1, 30);
-  auto pending = padStr(to_string(leaders.size() - fuzzStat.idx - 1), 5);
-  auto fav = count_if(leaders.begin(), leaders.end(), [](const pair<string, Leader> &p) {
-    return !p.second.item.fuzzedCount;
-  });
-  auto pendingFav = padStr(to_string(fav), 5);
+  auto addrDict1 = to_string(fuzzStat.stageFinds[STAGE_EXTRAS_AO]) + "/" + to_string(Mutation::stageCycles[STAGE_EXTRAS_AO]);
+  auto dict1 = to_string(fuzzStat.stageFinds[STAGE_EXTRAS_UO]) + "/" + to_string(Mutation::stageCycles[STAGE_EXTRAS_UO]);
+  auto i2s1 = to_string(fuzzStat.stageFinds[STAGE_I2S]) + "/" + to_string(Mutation::stageCycles[STAGE_I2S]);
+  auto dictionary = padStr(dict1 + ", " + addrDict1 + ", " + i2s1, 30);
+  auto hav1 = to_string(fuzzStat.stageFinds[STAGE_HAVOC]) + "/" + to_string(Mutation::stageCycles[STAGE_HAVOC]);
+  auto seq1 = to_string(fuzzStat.stageFinds[STAGE_SEQUENCE]) + "/" + to_string(Mutation::stageCycles[STAGE_SEQUENCE]);
+  auto abi1 = to_string(fuzzStat.stageFinds[STAGE_ABI]) + "/" + to_string(Mutation::stageCycles[STAGE_ABI]);
+  auto havoc = padStr(hav1 + ", " + abi1 + ", " + seq1, 30);
+  auto pending = padStr(to_string(numLeaders - fuzzStat.idx - 1), 5);
+  auto pendingFav = padStr(to_string(fuzzStat.numFresh), 5);
   auto maxdepthStr = padStr(to_string(fuzzStat.maxdepth), 5);
-  auto exceptionCount = padStr(to_string(uniqExceptions.size()), 5);
-  auto predicateSize = padStr(to_string(predicates.size()), 5);
+  auto exceptionCount = padStr(to_string(fuzzStat.numExceptions), 5);
+  auto predicateSize = padStr(to_string(fuzzStat.numPredicates), 5);
   auto contract = mainContract();
   auto toResult = [](bool val) { return val ? "found" : "none "; };
   printf(cGRN Bold "%sAFL Solidity v0.0.1 (%s)" cRST "\n", padStr("", 10).c_str(), contract.contractName.substr(0, 20).c_str());
@@ -129,89 +133,185 @@ void Fuzzer::showStats(const Mutation &mutation, const tuple<unordered_set<uint6
   printf(bBL bV20 bV2 bV10 bV5 bV2 bV bBTR bV10 bV5 bV20 bV2 bV2 bBR "\n");
 }
 
-void Fuzzer::writeStats(const Mutation &mutation) {
+void Fuzzer::writeStats() {
   auto contract = mainContract();
   stringstream ss;
   pt::ptree root;
   ofstream stats(contract.contractName + "/stats.json");
   root.put("duration", timer.elapsed());
-  root.put("totalExecs", fuzzStat.totalExecs);
+  root.put("totalExecs", fuzzStat.totalExecs.load());
   root.put("speed", (double) fuzzStat.totalExecs / timer.elapsed());
-  root.put("queueCycles", fuzzStat.queueCycle);
-  root.put("uniqExceptions", uniqExceptions.size());
+  root.put("queueCycles", fuzzStat.queueCycle.load());
+  root.put("uniqExceptions", fuzzStat.numExceptions.load());
+  root.put("coveredBranches", fuzzStat.numCovered.load());
+  /* Time to reach the final coverage, to compare schedules */
+  root.put("lastNewPath", fuzzStat.lastNewPath.load());
+  Findings found(vulnerabilities.load(memory_order_relaxed));
+  vector<pair<string, uint8_t>> oracles = {
+    {"gaslessSend", GASLESS_SEND}, {"exceptionDisorder", EXCEPTION_DISORDER},
+    {"timeDependency", TIME_DEPENDENCY}, {"numberDependency", NUMBER_DEPENDENCY},
+    {"delegateCall", DELEGATE_CALL}, {"reentrancy", REENTRANCY}, {"freezing", FREEZING},
+    {"overflow", OVERFLOW}, {"underflow", UNDERFLOW}
+  };
+  for (auto const& oracle : oracles) root.put("vulnerabilities." + oracle.first, (bool) found[oracle.second]);
+  pt::ptree samples;
+  for (auto const& it : fuzzStat.coverageSamples) {
+    pt::ptree sample;
+    sample.put("time", it.first);
+    sample.put("coveredBranches", it.second);
+    samples.push_back(make_pair("", sample));
+  }
+  root.add_child("coverage", samples);
   pt::write_json(ss, root);
   stats << ss.str() << endl;
   stats.close();
 }
 
+void Fuzzer::report(const ValidJumpis &validJumpis) {
+  switch (fuzzParam.reporter) {
+    case TERMINAL: {
+      showStats(validJumpis);
+      break;
+    }
+    case JSON: {
+      writeStats();
+      break;
+    }
+    case BOTH: {
+      showStats(validJumpis);
+      writeStats();
+      break;
+    }
+  }
+}
+
+void Fuzzer::reportLoop(const ValidJumpis &validJumpis) {
+  u64 lastShown = (u64) -1;
+  while (!stopped) {
+    u64 duration = timer.elapsed();
+    /* Show every one second, with the progress asked for at the previous one */
+    if (duration != lastShown) {
+      lastShown = duration;
+      auto &samples = fuzzStat.coverageSamples;
+      auto numCovered = fuzzStat.numCovered.load(memory_order_relaxed);
+      if (samples.empty() || samples.back().second != numCovered) samples.push_back(make_pair(duration, numCovered));
+      report(validJumpis);
+      progressWanted = true;
+      /* Stop program */
+      u64 speed = (u64)(fuzzStat.totalExecs / timer.elapsed());
+      if (timer.elapsed() > fuzzParam.duration || speed <= 10 || !fuzzStat.numPredicates) {
+        stopped = true;
+        break;
+      }
+    }
+    this_thread::sleep_for(chrono::milliseconds(50));
+  }
+}
+
+void Fuzzer::publishFrontier() {
+  fuzzStat.numLeaders.store(frontier.getLeaders().size(), memory_order_relaxed);
+  fuzzStat.numCovered.store(frontier.numCovered(), memory_order_relaxed);
+  fuzzStat.numPredicates.store(frontier.numPredicates(), memory_order_relaxed);
+  fuzzStat.numFresh.store(frontier.numFresh(), memory_order_relaxed);
+  fuzzStat.numExceptions.store(uniqExceptions.size(), memory_order_relaxed);
+}
+
+/* Cheap unless the reporter asked, then one worker copies its stage */
+void Fuzzer::publishProgress(const Mutation &mutation) {
+  if (!progressWanted.load(memory_order_relaxed) || !progressWanted.exchange(false)) return;
+  Guard l(x_progress);
+  progress.stageName = mutation.stageName;
+  progress.stageCur = mutation.stageCur;
+  progress.stageMax = mutation.stageMax;
+}
+
 /* Save data if interest */
-FuzzItem Fuzzer::saveIfInterest(TargetExecutive& te, bytes data, uint64_t depth, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>>& validJumpis) {
+FuzzItem Fuzzer::saveIfInterest(TargetExecutive& te, bytes data, const Sequence &sequence, uint64_t depth, const ValidJumpis& validJumpis, const FuzzItem *parent, uint64_t *newLeaders) {
   auto revisedData = ContractABI::postprocessTestData(data);
-  FuzzItem item(revisedData);
-  item.res = te.exec(revisedData, validJumpis);
-  //Logger::debug(Logger::testFormat(item.data));
-  fuzzStat.totalExecs ++;
+  FuzzItem item(revisedData, sequence);
+  auto start = chrono::steady_clock::now();
+  item.res = te.exec(revisedData, validJumpis, sequence);
+  double execCost = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  updateVulnerabilities(te.lastFindings);
+  //LOG_DEBUG(Logger::testFormat(item.data));
+  /* Execution is private to the worker, merging into the frontier is not */
+  bool changed;
+  {
+    Guard l(x_frontier);
+    auto leaders = mergeItem(item, depth, execCost, parent);
+    if (newLeaders) *newLeaders += leaders;
+    changed = !corpusQueue.empty();
+  }
+  if (changed) writeCorpus();
+  return item;
+}
+
+/* Update stats, leaders and corpus, new leaders inherit the effector map */
+size_t Fuzzer::mergeItem(FuzzItem &item, uint64_t depth, double execCost, const FuzzItem *parent) {
+  auto numLeaders = frontier.getLeaders().size();
+  auto inherits = parent && parent->eff.size() == item.data.size() && equal(item.data.begin(), item.data.begin() + 32, parent->data.begin());
+  fuzzStat.totalExecs.fetch_add(1, memory_order_relaxed);
+  fuzzStat.totalExecCost += execCost;
+  /* Stored once, however many branches it leads */
+  TestcaseRef testcase;
+  auto lead = [&](Leader &leader, BranchId branchId) {
+    if (inherits) leader.eff = parent->eff;
+    frontier.getStats(branchId).execCost = execCost;
+    updateEnergy(branchId);
+    corpusQueue.push_back(make_tuple(branchId, testcase, leader.comparisonValue));
+    if (depth + 1 > fuzzStat.maxdepth) fuzzStat.maxdepth = depth + 1;
+    fuzzStat.lastNewPath = timer.elapsed();
+  };
+  auto stored = [&]() {
+    item.depth = depth + 1;
+    if (!testcase) testcase = store.add(item);
+    return testcase;
+  };
   for (auto tracebit: item.res.tracebits) {
-    if (!tracebits.count(tracebit)) {
-      // Remove leader
-      auto lIt = find_if(leaders.begin(), leaders.end(), [=](const pair<string, Leader>& p) { return p.first == tracebit;});
-      if (lIt != leaders.end()) leaders.erase(lIt);
-      auto qIt = find_if(queues.begin(), queues.end(), [=](const string &s) { return s == tracebit; });
-      if (qIt == queues.end()) queues.push_back(tracebit);
-      // Insert leader
-      item.depth = depth + 1;
-      auto leader = Leader(item, 0);
-      leaders.insert(make_pair(tracebit, leader));
-      if (depth + 1 > fuzzStat.maxdepth) fuzzStat.maxdepth = depth + 1;
-      fuzzStat.lastNewPath = timer.elapsed();
-      Logger::debug("Cover new branch "  + tracebit);
-      Logger::debug(Logger::testFormat(item.data));
+    if (!frontier.isCovered(tracebit)) {
+      // Replace leader
+      lead(frontier.cover(tracebit, stored()), tracebit);
+      LOG_DEBUG("Cover new branch "  + branchToString(tracebit));
+      LOG_DEBUG(Logger::testFormat(item.data));
     }
   }
   for (auto predicateIt: item.res.predicates) {
-    auto lIt = find_if(leaders.begin(), leaders.end(), [=](const pair<string, Leader>& p) { return p.first == predicateIt.first;});
+    frontier.hit(predicateIt.first);
+    updateEnergy(predicateIt.first);
+    auto leader = frontier.findLeader(predicateIt.first);
     if (
-        lIt != leaders.end() // Found Leader
-        && lIt->second.comparisonValue > 0 // Not a covered branch
-        && lIt->second.comparisonValue > predicateIt.second // ComparisonValue is better
+        leader // Found Leader
+        && leader->comparisonValue > 0 // Not a covered branch
+        && leader->comparisonValue > predicateIt.second // ComparisonValue is better
     ) {
       // Debug now
-      Logger::debug("Found better test case for uncovered branch " + predicateIt.first);
-      Logger::debug("prev: " + lIt->second.comparisonValue.str());
-      Logger::debug("now : " + predicateIt.second.str());
+      LOG_DEBUG("Found better test case for uncovered branch " + branchToString(predicateIt.first));
+      LOG_DEBUG("prev: " + leader->comparisonValue.str());
+      LOG_DEBUG("now : " + predicateIt.second.str());
       // Stop debug
-      leaders.erase(lIt); // Remove leader
-      item.depth = depth + 1;
-      auto leader = Leader(item, predicateIt.second);
-      leaders.insert(make_pair(predicateIt.first, leader)); // Insert leader
-      if (depth + 1 > fuzzStat.maxdepth) fuzzStat.maxdepth = depth + 1;
-      fuzzStat.lastNewPath = timer.elapsed();
-      Logger::debug(Logger::testFormat(item.data));
-    } else if (lIt == leaders.end()) {
-      auto leader = Leader(item, predicateIt.second);
-      item.depth = depth + 1;
-      leaders.insert(make_pair(predicateIt.first, leader)); // Insert leader
-      queues.push_back(predicateIt.first);
-      if (depth + 1 > fuzzStat.maxdepth) fuzzStat.maxdepth = depth + 1;
-      fuzzStat.lastNewPath = timer.elapsed();
+      lead(frontier.approach(predicateIt.first, stored(), predicateIt.second), predicateIt.first); // Replace leader
+      LOG_DEBUG(Logger::testFormat(item.data));
+    } else if (!leader) {
+      lead(frontier.approach(predicateIt.first, stored(), predicateIt.second), predicateIt.first); // Insert leader
       // Debug
-      Logger::debug("Found new uncovered branch");
-      Logger::debug("now: " + predicateIt.second.str());
-      Logger::debug(Logger::testFormat(item.data));
+      LOG_DEBUG("Found new uncovered branch");
+      LOG_DEBUG("now: " + predicateIt.second.str());
+      LOG_DEBUG(Logger::testFormat(item.data));
     }
   }
+  /* Leaders surviving in mostly empty slabs are packed together */
+  if (store.wantsCompaction()) frontier.relocate(store.compact());
   updateExceptions(item.res.uniqExceptions);
-  updateTracebits(item.res.tracebits);
-  updatePredicates(item.res.predicates);
-  return item;
+  publishFrontier();
+  return frontier.getLeaders().size() - numLeaders;
 }
 
 /* Stop fuzzing */
-void Fuzzer::stop() {
-  Logger::debug("== TEST ==");
+void Fuzzer::stop(int status) {
+  LOG_DEBUG("== TEST ==");
   unordered_map<uint64_t, uint64_t> brs;
-  for (auto it : leaders) {
-    auto pc = stoi(splitString(it.first, ':')[0]);
+  for (auto it : frontier.getLeaders()) {
+    auto pc = branchFrom(it.first);
     // Covered
     if (it.second.comparisonValue == 0) {
       if (brs.find(pc) == brs.end()) {
@@ -220,249 +320,542 @@ void Fuzzer::stop() {
         brs[pc] += 1;
       }
     }
-    Logger::debug("BR " + it.first);
-    Logger::debug("ComparisonValue " + it.second.comparisonValue.str());
-    Logger::debug(Logger::testFormat(it.second.item.data));
+    LOG_DEBUG("BR " + branchToString(it.first));
+    LOG_DEBUG("ComparisonValue " + it.second.comparisonValue.str());
+    LOG_DEBUG(Logger::testFormat(it.second.item->data.toBytes()));
   }
-  Logger::debug("== END TEST ==");
+  LOG_DEBUG("== END TEST ==");
   for (auto it : snippets) {
     if (brs.find(it.first) == brs.end()) {
-      Logger::info(">> Unreachable");
-      Logger::info(it.second);
+      LOG_INFO(">> Unreachable");
+      LOG_INFO(it.second);
     } else {
       if (brs[it.first] == 1) {
-        Logger::info(">> Haft");
-        Logger::info(it.second);
+        LOG_INFO(">> Haft");
+        LOG_INFO(it.second);
       } else {
-        Logger::info(">> Full");
-        Logger::info(it.second);
+        LOG_INFO(">> Full");
+        LOG_INFO(it.second);
       }
     }
   }
-  exit(1);
+  exit(status);
 }
 
-/* Start fuzzing */
-void Fuzzer::start() {
-  TargetContainer container;
-  Dictionary codeDict, addressDict;
-  unordered_set<u64> showSet;
+/* Load attacker agents then the main contract into a container */
+TargetExecutive Fuzzer::loadContracts(TargetContainer &container, Dictionary &addressDict) {
   for (auto contractInfo : fuzzParam.contractInfo) {
     auto isAttacker = contractInfo.contractName.find(fuzzParam.attackerName) != string::npos;
-    if (!contractInfo.isMain && !isAttacker) continue;
+    if (contractInfo.isMain || !isAttacker) continue;
     ContractABI ca(contractInfo.abiJson);
-    auto bin = fromHex(contractInfo.bin);
-    auto binRuntime = fromHex(contractInfo.binRuntime);
-    // Accept only valid jumpis
-    auto executive = container.loadContract(bin, ca);
-    if (!contractInfo.isMain) {
-      /* Load Attacker agent contract */
-      auto data = ca.randomTestcase();
-      auto revisedData = ContractABI::postprocessTestData(data);
-      executive.deploy(revisedData, EMPTY_ONOP);
-      addressDict.fromAddress(executive.addr.asBytes());
-    } else {
-      auto contractName = contractInfo.contractName;
-      boost::filesystem::remove_all(contractName);
-      boost::filesystem::create_directory(contractName);
-      codeDict.fromCode(bin);
-      auto bytecodeBranch = BytecodeBranch(contractInfo);
-      auto validJumpis = bytecodeBranch.findValidJumpis();
-      snippets = bytecodeBranch.snippets;
-      if (!(get<0>(validJumpis).size() + get<1>(validJumpis).size())) {
-        cout << "No valid jumpi" << endl;
-        stop();
-      }
-      saveIfInterest(executive, ca.randomTestcase(), 0, validJumpis);
-      int originHitCount = leaders.size();
-      // No branch
-      if (!originHitCount) {
-        cout << "No branch" << endl;
-        stop();
-      }
-      // There are uncovered branches or not
-      auto fi = [&](const pair<string, Leader> &p) { return p.second.comparisonValue != 0;};
-      auto numUncoveredBranches = count_if(leaders.begin(), leaders.end(), fi);
-      if (!numUncoveredBranches) {
-        auto curItem = (*leaders.begin()).second.item;
-        Mutation mutation(curItem, make_tuple(codeDict, addressDict));
-        vulnerabilities = container.analyze();
-        switch (fuzzParam.reporter) {
-          case TERMINAL: {
-            showStats(mutation, validJumpis);
-            break;
-          }
-          case JSON: {
-            writeStats(mutation);
-            break;
-          }
-          case BOTH: {
-            showStats(mutation, validJumpis);
-            writeStats(mutation);
-            break;
-          }
-        }
-        stop();
+    auto executive = container.loadContract(fromHex(contractInfo.bin), ca);
+    /* Load Attacker agent contract */
+    auto data = ca.randomTestcase();
+    auto revisedData = ContractABI::postprocessTestData(data);
+    executive.deploy(revisedData, EMPTY_ONOP);
+    addressDict.fromAddress(executive.addr.asBytes());
+  }
+  auto contractInfo = mainContract();
+  ContractABI ca(contractInfo.abiJson);
+  return container.loadContract(fromHex(contractInfo.bin), ca);
+}
+
+void Fuzzer::updateEnergy(BranchId branchId) {
+  if (fuzzParam.schedule == EXPLOIT) return;
+  auto &queue = frontier.getQueue();
+  auto pos = frontier.queuePosition(branchId);
+  if (pos == queue.size()) return;
+  if (energies.size() < queue.size()) energies.resize(queue.size(), 0);
+  auto leader = frontier.findLeader(branchId);
+  /* Covered branches are never fuzzed */
+  auto energy = leader->comparisonValue ? leaderEnergy(fuzzParam.schedule, leader->comparisonValue, frontier.getStats(branchId), energyHits, energyExecCost) : 0;
+  totalEnergy += energy - energies[pos];
+  energies[pos] = energy;
+}
+
+void Fuzzer::refreshEnergies() {
+  auto averageHits = frontier.averageHits();
+  auto averageExecCost = fuzzStat.totalExecs ? fuzzStat.totalExecCost / fuzzStat.totalExecs : 0;
+  /* Averages move slowly, a full pass is only needed once they are off by a quarter */
+  auto drifted = [](double cached, double current) {
+    return abs(current - cached) > max(cached, 1.0) / 4;
+  };
+  if (!drifted(energyHits, averageHits) && !drifted(energyExecCost, averageExecCost)) return;
+  energyHits = averageHits;
+  energyExecCost = averageExecCost;
+  energies.assign(frontier.getQueue().size(), 0);
+  totalEnergy = 0;
+  for (auto branchId : frontier.getQueue()) updateEnergy(branchId);
+}
+
+/* Queue position of the next leader, round-robin unless the schedule weighs them */
+size_t Fuzzer::pickLeader() {
+  if (fuzzParam.schedule == EXPLOIT) return fuzzStat.idx;
+  refreshEnergies();
+  if (totalEnergy <= 0) return fuzzStat.idx;
+  auto point = (double) UR(1 << 30) / (1 << 30) * totalEnergy;
+  for (size_t i = 0; i < energies.size(); i ++) {
+    if (point < energies[i]) return i;
+    point -= energies[i];
+  }
+  return fuzzStat.idx;
+}
+
+/* Take the next leader from the shared queue, claim its deterministic stages if nobody did */
+tuple<BranchId, Leader, bool, double> Fuzzer::nextLeader() {
+  Guard l(x_frontier);
+  auto &queue = frontier.getQueue();
+  auto branchId = queue[pickLeader()];
+  auto leader = *frontier.findLeader(branchId);
+  auto &stats = frontier.getStats(branchId);
+  auto averageExecCost = fuzzStat.totalExecs ? fuzzStat.totalExecCost / fuzzStat.totalExecs : 0;
+  auto energy = leaderEnergy(fuzzParam.schedule, leader.comparisonValue, stats, frontier.averageHits(), averageExecCost);
+  stats.selected ++;
+  updateEnergy(branchId);
+  auto deterministic = !leader.fuzzedCount && !claimed.count(branchId);
+  if (deterministic) claimed.insert(branchId);
+  fuzzStat.idx = (fuzzStat.idx + 1) % queue.size();
+  if (fuzzStat.idx == 0) fuzzStat.queueCycle ++;
+  return make_tuple(branchId, leader, deterministic, energy);
+}
+
+/* Mark leader as fuzzed unless another worker has replaced it meanwhile */
+void Fuzzer::releaseLeader(BranchId branchId, TestcaseRef origin, const FuzzItem &item) {
+  Guard l(x_frontier);
+  claimed.erase(branchId);
+  auto leader = frontier.findLeader(branchId);
+  if (leader && leader->item->id == origin->id) {
+    frontier.markFuzzed(branchId);
+    if (item.eff.size()) leader->eff = item.eff;
+  }
+}
+
+/* Swap in the trimmed testcase unless another worker has replaced the leader meanwhile */
+TestcaseRef Fuzzer::replaceLeader(BranchId branchId, TestcaseRef origin, const FuzzItem &item) {
+  TestcaseRef ret;
+  {
+    Guard l(x_frontier);
+    auto leader = frontier.findLeader(branchId);
+    if (!leader || leader->item->id != origin->id) return origin;
+    auto replaced = item;
+    replaced.depth = origin->depth;
+    leader->item = store.add(replaced);
+    updateEnergy(branchId);
+    corpusQueue.push_back(make_tuple(branchId, leader->item, leader->comparisonValue));
+    ret = leader->item;
+  }
+  writeCorpus();
+  return ret;
+}
+
+/* Write the leaders queued by merges, in the order they changed */
+void Fuzzer::writeCorpus() {
+  Guard c(x_corpus);
+  vector<tuple<BranchId, TestcaseRef, u256>> queued;
+  {
+    Guard l(x_frontier);
+    queued.swap(corpusQueue);
+  }
+  for (auto const& it : queued) corpus.save(get<0>(it), get<1>(it)->toItem(), get<2>(it));
+}
+
+/* Fuzz loop of a worker, returns once the reporter stopped fuzzing */
+void Fuzzer::fuzzLoop(TargetExecutive &executive, const Dicts &dicts, const ValidJumpis &validJumpis, ExecutorPool &pool) {
+  ContractABI ca(mainContract().abiJson);
+  u32 numFuncs = ca.totalFuncs();
+  /* Leaders added by the merges of this worker since the last stage */
+  uint64_t newLeaders = 0;
+  /* Set for every leader, batches never outlive the stage which queued them */
+  OnBatchFunc mergeBatch;
+  BatchQueue batches(pool, [&](Batch &batch) { mergeBatch(batch); });
+  /* Credit new leaders to the stage which just finished */
+  auto countFinds = [&](int stage) {
+    batches.flush();
+    fuzzStat.stageFinds[stage] += newLeaders;
+    newLeaders = 0;
+  };
+  while (!stopped) {
+    auto next = nextLeader();
+    auto branchId = get<0>(next);
+    auto testcase = get<1>(next).item;
+    auto curItem = get<1>(next).load();
+    auto comparisonValue = get<1>(next).comparisonValue;
+    auto deterministic = get<2>(next);
+    /* Havoc length follows the energy of the schedule, at least one cycle */
+    u32 havocCycles = max((u32) (HAVOC_MIN * get<3>(next)), (u32) 1);
+    if (comparisonValue != 0) {
+      LOG_DEBUG(" == Leader ==");
+      LOG_DEBUG("Branch \t\t\t\t " + branchToString(branchId));
+      LOG_DEBUG("Comp \t\t\t\t " + comparisonValue.str());
+      LOG_DEBUG("Fuzzed \t\t\t\t " + to_string(curItem.fuzzedCount));
+      LOG_DEBUG(Logger::testFormat(curItem.data));
+    }
+    auto leaderDicts = dicts;
+    get<2>(leaderDicts) = runtimeDict.snapshot();
+    Mutation mutation(curItem, leaderDicts, ca);
+    /* Stats and stop conditions are handled by the reporter thread */
+    auto run = [&](bytes data, const Sequence &sequence) {
+      if (stopped) throw FuzzStopped();
+      auto item = saveIfInterest(executive, data, sequence, curItem.depth, validJumpis, &curItem, &newLeaders);
+      publishProgress(mutation);
+      return item;
+    };
+    mergeBatch = [&](Batch &batch) {
+      bool changed;
+      {
+        Guard l(x_frontier);
+        for (size_t i = 0; i < batch.size; i ++) newLeaders += mergeItem(batch.items[i], curItem.depth, batch.execCosts[i], &curItem);
+        changed = !corpusQueue.empty();
       }
-      // Jump to fuzz loop
-      while (true) {
-        auto leaderIt = leaders.find(queues[fuzzStat.idx]);
-        auto curItem = leaderIt->second.item;
-        auto comparisonValue = leaderIt->second.comparisonValue;
-        if (comparisonValue != 0) {
-          Logger::debug(" == Leader ==");
-          Logger::debug("Branch \t\t\t\t " + leaderIt->first);
-          Logger::debug("Comp \t\t\t\t " + comparisonValue.str());
-          Logger::debug("Fuzzed \t\t\t\t " + to_string(curItem.fuzzedCount));
-          Logger::debug(Logger::testFormat(curItem.data));
-        }
-        Mutation mutation(curItem, make_tuple(codeDict, addressDict));
-        auto save = [&](bytes data) {
-          auto item = saveIfInterest(executive, data, curItem.depth, validJumpis);
-          /* Show every one second */
-          u64 duration = timer.elapsed();
-          if (!showSet.count(duration)) {
-            showSet.insert(duration);
-            if (duration % fuzzParam.analyzingInterval == 0) {
-              vulnerabilities = container.analyze();
-            }
-            switch (fuzzParam.reporter) {
-              case TERMINAL: {
-                showStats(mutation, validJumpis);
-                break;
-              }
-              case JSON: {
-                writeStats(mutation);
-                break;
-              }
-              case BOTH: {
-                showStats(mutation, validJumpis);
-                writeStats(mutation);
-                break;
-              }
-            }
+      if (changed) writeCorpus();
+    };
+    /*
+     * Stages which never read the result of a candidate queue it to the
+     * executor pool and go on generating, they get the unexecuted item back
+     */
+    auto queue = [&](bytes data) {
+      if (stopped) throw FuzzStopped();
+      publishProgress(mutation);
+      batches.push(data, curItem.sequence);
+      return FuzzItem(data, curItem.sequence);
+    };
+    auto queueSequence = [&](Sequence sequence) {
+      if (stopped) throw FuzzStopped();
+      publishProgress(mutation);
+      batches.push(curItem.data, sequence);
+      return FuzzItem(curItem.data, sequence);
+    };
+    auto save = [&](bytes data) { return run(data, curItem.sequence); };
+    try {
+      // If it is uncovered branch
+      if (comparisonValue != 0) {
+        // Haven't fuzzed before
+        if (deterministic) {
+          LOG_DEBUG("Trim");
+          auto origin = curItem.data;
+          auto expected = run(curItem.data, curItem.sequence);
+          auto outcome = executive.lastFindings;
+          /* Same path, but comparison values may differ: keep what the trimmed testcase ran */
+          auto trimmed = expected.res;
+          auto keeps = [&](const FuzzItem &item) {
+            if (item.res.cksum != expected.res.cksum || executive.lastFindings != outcome) return false;
+            trimmed = item.res;
+            return true;
+          };
+          curItem.data = mutation.trim(ca, save, keeps);
+          if (curItem.data != origin) {
+            curItem.res = trimmed;
+            testcase = replaceLeader(branchId, testcase, curItem);
           }
-          /* Stop program */
-          u64 speed = (u64)(fuzzStat.totalExecs / timer.elapsed());
-          if (timer.elapsed() > fuzzParam.duration || speed <= 10 || !predicates.size()) {
-            vulnerabilities = container.analyze();
-            switch(fuzzParam.reporter) {
-              case TERMINAL: {
-                showStats(mutation, validJumpis);
-                break;
-              }
-              case JSON: {
-                writeStats(mutation);
-                break;
-              }
-              case BOTH: {
-                showStats(mutation, validJumpis);
-                writeStats(mutation);
-                break;
-              }
+
+          LOG_DEBUG("InputToState");
+          executive.logComparisons = executive.harvestValues = executive.traceTaint = true;
+          run(curItem.data, curItem.sequence);
+          executive.logComparisons = executive.harvestValues = executive.traceTaint = false;
+          runtimeDict.add(executive.lastValues);
+          /* Values of this leader are overwritten by its own dictionary stage */
+          mutation.setRuntimeDictionary(runtimeDict.snapshot());
+          /* Later stages only touch the bytes feeding the condition of the leader */
+          auto taint = executive.lastTaint.find(branchFrom(branchId));
+          if (taint != executive.lastTaint.end()) mutation.focus(taint->second);
+          mutation.inputToState(executive.lastComparisons, queue);
+          countFinds(STAGE_I2S);
+
+          LOG_DEBUG("LocalSearch");
+          auto distance = [&](const FuzzItem &item) -> u256 {
+            if (find(item.res.tracebits.begin(), item.res.tracebits.end(), branchId) != item.res.tracebits.end()) return 0;
+            for (auto const& predicate : item.res.predicates) {
+              if (predicate.first == branchId) return predicate.second;
             }
-            stop();
+            /* The comparison was not reached */
+            return ~u256(0);
+          };
+          /* The leader is where the search starts, its stored result gives the distance */
+          mutation.localSearch(save, distance, distance(curItem));
+          countFinds(STAGE_SEARCH);
+
+          LOG_DEBUG("SingleWalkingBit");
+          mutation.singleWalkingBit(queue);
+          countFinds(STAGE_FLIP1);
+
+          LOG_DEBUG("TwoWalkingBit");
+          mutation.twoWalkingBit(queue);
+          countFinds(STAGE_FLIP2);
+
+          LOG_DEBUG("FourWalkingBtit");
+          mutation.fourWalkingBit(queue);
+          countFinds(STAGE_FLIP4);
+
+          LOG_DEBUG("SingleWalkingByte");
+          mutation.singleWalkingByte(save);
+          countFinds(STAGE_FLIP8);
+          curItem.eff = mutation.effector();
+
+          LOG_DEBUG("TwoWalkingByte");
+          mutation.twoWalkingByte(queue);
+          countFinds(STAGE_FLIP16);
+
+          LOG_DEBUG("FourWalkingByte");
+          mutation.fourWalkingByte(queue);
+          countFinds(STAGE_FLIP32);
+
+          //LOG_DEBUG("SingleArith");
+          //mutation.singleArith(save);
+          //countFinds(STAGE_ARITH8);
+
+          //LOG_DEBUG("TwoArith");
+          //mutation.twoArith(save);
+          //countFinds(STAGE_ARITH16);
+
+          //LOG_DEBUG("FourArith");
+          //mutation.fourArith(save);
+          //countFinds(STAGE_ARITH32);
+
+          //LOG_DEBUG("SingleInterest");
+          //mutation.singleInterest(save);
+          //countFinds(STAGE_INTEREST8);
+
+          //LOG_DEBUG("TwoInterest");
+          //mutation.twoInterest(save);
+          //countFinds(STAGE_INTEREST16);
+
+          //LOG_DEBUG("FourInterest");
+          //mutation.fourInterest(save);
+          //countFinds(STAGE_INTEREST32);
+
+          LOG_DEBUG("overwriteDict");
+          mutation.overwriteWithDictionary(save);
+          countFinds(STAGE_EXTRAS_UO);
+          runtimeDict.credit(mutation.runtimeDictionary());
+
+          LOG_DEBUG("overwriteAddress");
+          mutation.overwriteWithAddressDictionary(queue);
+          countFinds(STAGE_EXTRAS_AO);
+
+          LOG_DEBUG("havoc");
+          mutation.havoc(queue, havocCycles);
+          countFinds(STAGE_HAVOC);
+
+          LOG_DEBUG("abiHavoc");
+          mutation.abiHavoc(ca, queue, havocCycles);
+          countFinds(STAGE_ABI);
+
+          LOG_DEBUG("sequence");
+          mutation.havocSequence(queueSequence, numFuncs);
+          countFinds(STAGE_SEQUENCE);
+        } else {
+          LOG_DEBUG("havoc");
+          mutation.havoc(queue, havocCycles);
+          countFinds(STAGE_HAVOC);
+          LOG_DEBUG("abiHavoc");
+          mutation.abiHavoc(ca, queue, havocCycles);
+          countFinds(STAGE_ABI);
+          LOG_DEBUG("sequence");
+          mutation.havocSequence(queueSequence, numFuncs);
+          countFinds(STAGE_SEQUENCE);
+          LOG_DEBUG("Splice");
+          vector<TestcaseRef> items = {};
+          {
+            Guard l(x_frontier);
+            for (auto const& it : frontier.getLeaders()) items.push_back(it.second.item);
           }
-          return item;
-        };
-        // If it is uncovered branch
-        if (comparisonValue != 0) {
-          // Haven't fuzzed before
-          if (!curItem.fuzzedCount) {
-            Logger::debug("SingleWalkingBit");
-            mutation.singleWalkingBit(save);
-            fuzzStat.stageFinds[STAGE_FLIP1] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            Logger::debug("TwoWalkingBit");
-            mutation.twoWalkingBit(save);
-            fuzzStat.stageFinds[STAGE_FLIP2] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            Logger::debug("FourWalkingBtit");
-            mutation.fourWalkingBit(save);
-            fuzzStat.stageFinds[STAGE_FLIP4] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            Logger::debug("SingleWalkingByte");
-            mutation.singleWalkingByte(save);
-            fuzzStat.stageFinds[STAGE_FLIP8] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            Logger::debug("TwoWalkingByte");
-            mutation.twoWalkingByte(save);
-            fuzzStat.stageFinds[STAGE_FLIP16] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            Logger::debug("FourWalkingByte");
-            mutation.fourWalkingByte(save);
-            fuzzStat.stageFinds[STAGE_FLIP32] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            //Logger::debug("SingleArith");
-            //mutation.singleArith(save);
-            //fuzzStat.stageFinds[STAGE_ARITH8] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            //Logger::debug("TwoArith");
-            //mutation.twoArith(save);
-            //fuzzStat.stageFinds[STAGE_ARITH16] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            //Logger::debug("FourArith");
-            //mutation.fourArith(save);
-            //fuzzStat.stageFinds[STAGE_ARITH32] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            //Logger::debug("SingleInterest");
-            //mutation.singleInterest(save);
-            //fuzzStat.stageFinds[STAGE_INTEREST8] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            //Logger::debug("TwoInterest");
-            //mutation.twoInterest(save);
-            //fuzzStat.stageFinds[STAGE_INTEREST16] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            //Logger::debug("FourInterest");
-            //mutation.fourInterest(save);
-            //fuzzStat.stageFinds[STAGE_INTEREST32] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            //Logger::debug("overwriteDict");
-            //mutation.overwriteWithDictionary(save);
-            //fuzzStat.stageFinds[STAGE_EXTRAS_UO] += leaders.size() - originHitCount;
-            //originHitCount = leaders.size();
-
-            Logger::debug("overwriteAddress");
-            mutation.overwriteWithAddressDictionary(save);
-            fuzzStat.stageFinds[STAGE_EXTRAS_AO] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-
-            Logger::debug("havoc");
-            mutation.havoc(save);
-            fuzzStat.stageFinds[STAGE_HAVOC] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-          } else {
-            Logger::debug("havoc");
-            mutation.havoc(save);
-            fuzzStat.stageFinds[STAGE_HAVOC] += leaders.size() - originHitCount;
-            originHitCount = leaders.size();
-            Logger::debug("Splice");
-            vector<FuzzItem> items = {};
-            for (auto it : leaders) items.push_back(it.second.item);
-            if (mutation.splice(items)) {
-              Logger::debug("havoc");
-              mutation.havoc(save);
-              fuzzStat.stageFinds[STAGE_HAVOC] += leaders.size() - originHitCount;
-              originHitCount = leaders.size();
-            }
+          if (mutation.splice(items)) {
+            LOG_DEBUG("havoc");
+            mutation.havoc(queue, havocCycles);
+            countFinds(STAGE_HAVOC);
           }
         }
-        leaderIt->second.item.fuzzedCount += 1;
-        fuzzStat.idx = (fuzzStat.idx + 1) % leaders.size();
-        if (fuzzStat.idx == 0) fuzzStat.queueCycle ++;
       }
+    } catch (FuzzStopped &) {
+      batches.cancel();
+      curItem.eff = mutation.effector();
+      releaseLeader(branchId, testcase, curItem);
+      return;
     }
+    /* Later cycles and children of this leader start from what was learnt */
+    curItem.eff = mutation.effector();
+    releaseLeader(branchId, testcase, curItem);
   }
 }
+
+/* Start fuzzing */
+void Fuzzer::start() {
+  Dictionary codeDict, addressDict;
+  auto contractInfo = mainContract();
+  auto contractName = contractInfo.contractName;
+  ContractABI ca(contractInfo.abiJson);
+  auto corpusFolder = contractName + "/corpus";
+  /* Testcases of the previous run, read before the index is reopened */
+  auto resumed = fuzzParam.resume ? Corpus::load(corpusFolder) : vector<FuzzItem>();
+  if (!fuzzParam.resume) boost::filesystem::remove_all(contractName);
+  boost::filesystem::create_directory(contractName);
+  corpus.open(corpusFolder);
+  codeDict.fromCode(fromHex(contractInfo.bin));
+  auto bytecodeBranch = BytecodeBranch(contractInfo);
+  ValidJumpis validJumpis = bytecodeBranch.findValidJumpis();
+  snippets = bytecodeBranch.snippets;
+  if (!(get<0>(validJumpis).size() + get<1>(validJumpis).size())) {
+    cout << "No valid jumpi" << endl;
+    stop(1);
+  }
+  /* The calling thread is the first worker */
+  TargetContainer container;
+  auto executive = loadContracts(container, addressDict);
+  auto dicts = make_tuple(codeDict, addressDict, Dictionary());
+  saveIfInterest(executive, ca.randomTestcase(), Sequence(), 0, validJumpis);
+  for (auto const& item : resumed) {
+    saveIfInterest(executive, item.data, item.sequence, item.depth ? item.depth - 1 : 0, validJumpis);
+  }
+  if (!fuzzParam.seedsDir.empty()) {
+    for (auto item : Corpus::loadSeeds(fuzzParam.seedsDir)) {
+      /* Raw seeds must at least hold the lengths, sender and block */
+      if (item.data.size() < 96) item.data.resize(96, 0);
+      saveIfInterest(executive, item.data, item.sequence, 0, validJumpis);
+    }
+  }
+  // No branch
+  auto &leaders = frontier.getLeaders();
+  if (!leaders.size()) {
+    cout << "No branch" << endl;
+    stop(1);
+  }
+  // There are uncovered branches or not
+  auto fi = [&](const pair<BranchId, Leader> &p) { return p.second.comparisonValue != 0;};
+  auto numUncoveredBranches = count_if(leaders.begin(), leaders.end(), fi);
+  if (!numUncoveredBranches) {
+    report(validJumpis);
+    stop();
+  }
+  /* Jobs are split between workers and executors, with one of each at least */
+  auto numWorkers = max(fuzzParam.jobs / 2, 1);
+  /* Executors own a private container too, they execute the batches of every worker */
+  ExecutorPool pool(max(fuzzParam.jobs - numWorkers, 1), [&]() -> OnBatchFunc {
+    auto executorContainer = make_shared<TargetContainer>();
+    Dictionary executorAddressDict;
+    auto executorExecutive = make_shared<TargetExecutive>(loadContracts(*executorContainer, executorAddressDict));
+    return [=](Batch &batch) {
+      for (size_t i = 0; i < batch.size; i ++) {
+        auto &item = batch.items[i];
+        item.data = ContractABI::postprocessTestData(item.data);
+        auto start = chrono::steady_clock::now();
+        item.res = executorExecutive->exec(item.data, validJumpis, item.sequence);
+        batch.execCosts[i] = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        updateVulnerabilities(executorExecutive->lastFindings);
+      }
+    };
+  });
+  /* Other workers own a private container, sharing only the frontier */
+  vector<thread> workers;
+  for (int i = 1; i < numWorkers; i ++) {
+    workers.push_back(thread([&]() {
+      TargetContainer workerContainer;
+      Dictionary workerAddressDict;
+      auto workerExecutive = loadContracts(workerContainer, workerAddressDict);
+      fuzzLoop(workerExecutive, dicts, validJumpis, pool);
+    }));
+  }
+  /* Terminal and file output never block the workers */
+  thread reporter([&]() { reportLoop(validJumpis); });
+  fuzzLoop(executive, dicts, validJumpis, pool);
+  for (auto &worker : workers) worker.join();
+  reporter.join();
+  pool.stop();
+  report(validJumpis);
+  stop();
+}
+
+void Fuzzer::minimize(string inFolder, string outFolder) {
+  auto contractInfo = mainContract();
+  auto validJumpis = BytecodeBranch(contractInfo).findValidJumpis();
+  auto items = Corpus::loadSeeds(inFolder);
+  vector<double> costs(items.size(), 1);
+  /* Workers take inputs in turn and fill their own slots, no lock needed */
+  atomic<size_t> next(0);
+  auto replay = [&]() {
+    TargetContainer container;
+    Dictionary addressDict;
+    auto executive = loadContracts(container, addressDict);
+    for (auto idx = next++; idx < items.size(); idx = next++) {
+      auto &item = items[idx];
+      if (item.data.size() < 96) item.data.resize(96, 0);
+      item.data = ContractABI::postprocessTestData(item.data);
+      auto start = chrono::steady_clock::now();
+      item.res = executive.exec(item.data, validJumpis, item.sequence);
+      auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+      costs[idx] = (double) item.data.size() * max((double) elapsed, 1.0);
+    }
+  };
+  vector<thread> workers;
+  for (int i = 1; i < fuzzParam.jobs; i ++) workers.push_back(thread(replay));
+  replay();
+  for (auto &worker : workers) worker.join();
+  /* Keep every tracebit and exception, and for uncovered predicates the closest inputs */
+  enum FeatureKind { TRACEBIT, PREDICATE, EXCEPTION };
+  unordered_set<BranchId> tracebits;
+  unordered_map<BranchId, u256> bestValues;
+  for (auto const& item : items) {
+    for (auto tracebit : item.res.tracebits) tracebits.insert(tracebit);
+    for (auto const& predicate : item.res.predicates) {
+      auto it = bestValues.find(predicate.first);
+      if (it == bestValues.end() || predicate.second < it->second) bestValues[predicate.first] = predicate.second;
+    }
+  }
+  map<pair<int, uint64_t>, uint64_t> featureIds;
+  vector<pair<int, uint64_t>> featureKeys;
+  auto toFeature = [&](int kind, uint64_t id) -> uint64_t {
+    auto key = make_pair(kind, id);
+    auto it = featureIds.find(key);
+    if (it != featureIds.end()) return it->second;
+    featureKeys.push_back(key);
+    return featureIds[key] = featureKeys.size() - 1;
+  };
+  vector<vector<uint64_t>> features(items.size());
+  for (size_t i = 0; i < items.size(); i ++) {
+    auto const& res = items[i].res;
+    for (auto tracebit : res.tracebits) features[i].push_back(toFeature(TRACEBIT, tracebit));
+    for (auto const& predicate : res.predicates) {
+      if (tracebits.count(predicate.first) || predicate.second != bestValues[predicate.first]) continue;
+      features[i].push_back(toFeature(PREDICATE, predicate.first));
+    }
+    for (auto exception : res.uniqExceptions) features[i].push_back(toFeature(EXCEPTION, exception));
+  }
+  Corpus out;
+  out.open(outFolder);
+  auto chosen = Corpus::cover(features, costs);
+  for (auto const& it : chosen) {
+    auto const& item = items[it.first];
+    out.write(item);
+    for (auto feature : it.second) {
+      auto key = featureKeys[feature];
+      if (key.first == TRACEBIT) out.save(key.second, item, 0);
+      if (key.first == PREDICATE) out.save(key.second, item, bestValues[key.second]);
+    }
+  }
+  cout << "[+] " << items.size() << " testcases minimized to " << chosen.size() << endl;
+}
+
+void Fuzzer::trim(string inFile, string outFile) {
+  auto contractInfo = mainContract();
+  ContractABI ca(contractInfo.abiJson);
+  auto validJumpis = BytecodeBranch(contractInfo).findValidJumpis();
+  auto origin = Corpus::decode(contents(inFile));
+  if (origin.data.size() < 96) origin.data.resize(96, 0);
+  TargetContainer container;
+  Dictionary addressDict;
+  auto executive = loadContracts(container, addressDict);
+  auto exec = [&](bytes data) {
+    FuzzItem item(ContractABI::postprocessTestData(data), origin.sequence);
+    item.res = executive.exec(item.data, validJumpis, item.sequence);
+    return item;
+  };
+  auto expected = exec(origin.data);
+  auto outcome = executive.lastFindings;
+  auto keeps = [&](const FuzzItem &item) {
+    return item.res.cksum == expected.res.cksum && executive.lastFindings == outcome;
+  };
+  Mutation mutation(expected, Dicts());
+  auto item = origin;
+  item.data = mutation.trim(ca, exec, keeps, true);
+  writeFile(outFile, Corpus::encode(item));
+  cout << "[+] " << origin.data.size() << " bytes trimmed to " << item.data.size() << " in " << mutation.stageCur << " execs" << endl;
+}
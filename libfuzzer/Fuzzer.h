@@ -1,11 +1,17 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <libdevcore/Guards.h>
 #include <liboracle/Common.h>
 #include "ContractABI.h"
 #include "Util.h"
 #include "FuzzItem.h"
+#include "Frontier.h"
+#include "Corpus.h"
+#include "PowerSchedule.h"
 #include "Mutation.h"
+#include "ExecutorPool.h"
 
 using namespace dev;
 using namespace eth;
@@ -30,46 +36,116 @@ namespace fuzzer {
     FuzzMode mode;
     Reporter reporter;
     int duration;
-    int analyzingInterval;
+    /* Threads of a run, half fuzz and merge, the others execute their batches. Two at least */
+    int jobs;
     string attackerName;
+    /* Keep the corpus of the previous run and replay it first */
+    bool resume;
+    /* Folder of testcases to replay before fuzzing, empty for none */
+    string seedsDir;
+    PowerSchedule schedule;
   };
+  /*
+   * Counters are written by the workers, mostly under x_frontier, and read
+   * by the reporter thread without any lock
+   */
   struct FuzzStat {
-    int idx = 0;
-    uint64_t maxdepth = 0;
+    atomic<int> idx{0};
+    atomic<uint64_t> maxdepth{0};
+    atomic<uint64_t> totalExecs{0};
+    atomic<int> queueCycle{0};
+    atomic<uint64_t> stageFinds[32];
+    atomic<double> lastNewPath{0};
+    /* Frontier sizes, published after every merge */
+    atomic<uint64_t> numLeaders{0};
+    atomic<uint64_t> numCovered{0};
+    atomic<uint64_t> numPredicates{0};
+    atomic<uint64_t> numFresh{0};
+    atomic<uint64_t> numExceptions{0};
+    /* Sum of execution times in microseconds, guarded by x_frontier */
+    double totalExecCost = 0;
+    /* Reporter only */
     bool clearScreen = false;
-    int totalExecs = 0;
-    int queueCycle = 0;
-    int stageFinds[32];
-    double lastNewPath = 0;
+    /* Seconds and covered branches every time coverage grew, to compare schedules */
+    vector<pair<uint64_t, uint64_t>> coverageSamples;
   };
-  struct Leader {
-    FuzzItem item;
-    u256 comparisonValue = 0;
-    Leader(FuzzItem _item, u256 _comparisionValue): item(_item) {
-      comparisonValue = _comparisionValue;
-    }
+  /* Stage of a worker, copied out when the reporter asks for it */
+  struct StageProgress {
+    string stageName = "init";
+    uint64_t stageCur = 0;
+    uint64_t stageMax = 0;
   };
+  using ValidJumpis = tuple<unordered_set<uint64_t>, unordered_set<uint64_t>>;
   class Fuzzer {
-    vector<bool> vulnerabilities;
-    vector<string> queues;
-    unordered_set<string> tracebits;
-    unordered_set<string> predicates;
-    unordered_map<string, Leader> leaders;
+    /* One bit per oracle, see Findings */
+    atomic<unsigned long> vulnerabilities;
+    Frontier frontier;
+    Corpus corpus;
+    /* Testcases of the leaders, guarded by x_frontier */
+    TestcaseStore store;
+    /* Leader changes waiting to be written to the corpus, guarded by x_frontier */
+    vector<tuple<BranchId, TestcaseRef, u256>> corpusQueue;
+    /* Held while writing the corpus, taken before x_frontier */
+    Mutex x_corpus;
+    /* Energy of every queue position and their sum, guarded by x_frontier */
+    vector<double> energies;
+    double totalEnergy = 0;
+    /* Averages the energies were computed with */
+    double energyHits = 0;
+    double energyExecCost = 0;
+    /* Leaders whose deterministic stages are running on some worker */
+    unordered_set<BranchId> claimed;
+    /* Values harvested once per leader, snapshotted into the dicts of every leader */
+    RuntimeDictionary runtimeDict;
     unordered_map<uint64_t, string> snippets;
-    unordered_set<string> uniqExceptions;
+    unordered_set<uint64_t> uniqExceptions;
     Timer timer;
     FuzzParam fuzzParam;
     FuzzStat fuzzStat;
-    void writeStats(const Mutation &mutation);
+    /* Guards the coverage frontier, leaders and stats shared by workers */
+    Mutex x_frontier;
+    atomic<bool> stopped;
+    StageProgress progress;
+    Mutex x_progress;
+    atomic<bool> progressWanted;
+    void writeStats();
+    void report(const ValidJumpis &validJumpis);
+    /* Renders stats and checks the stop conditions on its own thread until stopped */
+    void reportLoop(const ValidJumpis &validJumpis);
+    /* Copy the frontier sizes to the stats, x_frontier must be held */
+    void publishFrontier();
+    void publishProgress(const Mutation &mutation);
+    /* Disk writes of the queued leader changes, outside x_frontier */
+    void writeCorpus();
     ContractInfo mainContract();
+    TargetExecutive loadContracts(TargetContainer &container, Dictionary &addressDict);
+    /* Branch, its leader, whether deterministic stages are claimed and its energy */
+    tuple<BranchId, Leader, bool, double> nextLeader();
+    size_t pickLeader();
+    /* Recompute the energy of a leader whose stats changed, x_frontier must be held */
+    void updateEnergy(BranchId branchId);
+    /* Recompute every energy once the averages drifted too far from the cached ones */
+    void refreshEnergies();
+    void releaseLeader(BranchId branchId, TestcaseRef origin, const FuzzItem &item);
+    /* Returns the new testcase of the leader, origin if it was replaced meanwhile */
+    TestcaseRef replaceLeader(BranchId branchId, TestcaseRef origin, const FuzzItem &item);
+    /* Merge an executed testcase into the frontier, x_frontier must be held. Returns the number of new leaders */
+    size_t mergeItem(FuzzItem &item, uint64_t depth, double execCost, const FuzzItem *parent);
+    void fuzzLoop(TargetExecutive &executive, const Dicts &dicts, const ValidJumpis &validJumpis, ExecutorPool &pool);
     public:
       Fuzzer(FuzzParam fuzzParam);
-      FuzzItem saveIfInterest(TargetExecutive& te, bytes data, uint64_t depth, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>> &validJumpis);
-      void showStats(const Mutation &mutation, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>> &validJumpis);
-      void updateTracebits(unordered_set<string> tracebits);
-      void updatePredicates(unordered_map<string, u256> predicates);
-      void updateExceptions(unordered_set<string> uniqExceptions);
+      /* New leaders inherit the effector map of parent when the layout is the same, their number is added to newLeaders */
+      FuzzItem saveIfInterest(TargetExecutive& te, bytes data, const Sequence &sequence, uint64_t depth, const ValidJumpis &validJumpis, const FuzzItem *parent = nullptr, uint64_t *newLeaders = nullptr);
+      void showStats(const ValidJumpis &validJumpis);
+      void updateExceptions(const unordered_set<uint64_t> &uniqExceptions);
+      /* Merge oracle results of an execution, lock free */
+      void updateVulnerabilities(Findings const& findings);
       void start();
-      void stop();
+      /* Log the branch report and exit the process, with status 1 if there was nothing to fuzz */
+      void stop(int status = 0);
+      /* Replay a corpus and keep the smallest cheap set reaching the same features */
+      void minimize(string inFolder, string outFolder);
+      /* Shrink one testcase keeping its path hash and oracle results */
+      void trim(string inFile, string outFile);
   };
 }
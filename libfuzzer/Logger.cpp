@@ -1,25 +1,147 @@
+#include <thread>
+#include <chrono>
 #include "Logger.h"
 
 using namespace std;
 
 namespace fuzzer {
-  ofstream Logger::debugFile = ofstream("debug.txt", ios_base::app);
-  ofstream Logger::infoFile = ofstream("info.txt", ios_base::app);
-  bool Logger::enabled = true;
+  namespace {
+    size_t LOG_RING_SIZE = 1 << 14;
 
-  void Logger::debug(string str) {
-    if (enabled) {
-      debugFile << str << endl;
+    class Writer {
+      LogRing ring;
+      ofstream debugFile;
+      ofstream infoFile;
+      atomic<bool> stopping;
+      uint64_t written = 0;
+      /* Lines written and flushed, compared with the pushed ones by flush */
+      atomic<uint64_t> synced;
+      thread worker;
+      bool drain() {
+        int level;
+        string message;
+        bool any = false;
+        while (ring.pop(level, message)) {
+          auto &file = level == Logger::DEBUG ? debugFile : infoFile;
+          file << message << '\n';
+          written ++;
+          any = true;
+        }
+        return any;
+      }
+      public:
+        atomic<uint64_t> pushed;
+        atomic<uint64_t> dropped;
+        Writer():
+          ring(LOG_RING_SIZE),
+          debugFile("debug.txt", ios_base::app),
+          infoFile("info.txt", ios_base::app),
+          stopping(false), synced(0), pushed(0), dropped(0) {
+          worker = thread([this]() {
+            while (!stopping) {
+              if (drain()) continue;
+              debugFile.flush();
+              infoFile.flush();
+              synced = written;
+              this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            drain();
+          });
+        }
+        ~Writer() {
+          stopping = true;
+          worker.join();
+        }
+        void push(int level, string &&message) {
+          if (!ring.push(level, move(message))) {
+            dropped ++;
+            return;
+          }
+          pushed ++;
+        }
+        void flush() {
+          while (synced < pushed) this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    };
+
+    /* Started on first use, stopped and drained at exit */
+    Writer &writer() {
+      static Writer instance;
+      return instance;
     }
   }
 
-  void Logger::info(string str) {
-    if (enabled) {
-      infoFile << str << endl;
+  LogRing::LogRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; i ++) cells[i].sequence.store(i, memory_order_relaxed);
+    mask = size - 1;
+    enqueuePos.store(0, memory_order_relaxed);
+    dequeuePos.store(0, memory_order_relaxed);
+  }
+
+  bool LogRing::push(int level, string &&message) {
+    Cell *cell;
+    auto pos = enqueuePos.load(memory_order_relaxed);
+    while (true) {
+      cell = &cells[pos & mask];
+      auto seq = cell->sequence.load(memory_order_acquire);
+      auto diff = (intptr_t) seq - (intptr_t) pos;
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueuePos.load(memory_order_relaxed);
+      }
     }
+    cell->level = level;
+    cell->message = move(message);
+    cell->sequence.store(pos + 1, memory_order_release);
+    return true;
+  }
+
+  bool LogRing::pop(int &level, string &message) {
+    Cell *cell;
+    auto pos = dequeuePos.load(memory_order_relaxed);
+    while (true) {
+      cell = &cells[pos & mask];
+      auto seq = cell->sequence.load(memory_order_acquire);
+      auto diff = (intptr_t) seq - (intptr_t) (pos + 1);
+      if (diff == 0) {
+        if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeuePos.load(memory_order_relaxed);
+      }
+    }
+    level = cell->level;
+    message = move(cell->message);
+    cell->sequence.store(pos + mask + 1, memory_order_release);
+    return true;
+  }
+
+  atomic<int> Logger::level(DEBUG);
+
+  void Logger::debug(string str) {
+    if (isOn(DEBUG)) writer().push(DEBUG, move(str));
+  }
+
+  void Logger::info(string str) {
+    if (isOn(INFO)) writer().push(INFO, move(str));
+  }
+
+  void Logger::flush() {
+    writer().flush();
+  }
+
+  uint64_t Logger::dropped() {
+    return writer().dropped;
   }
 
-  string Logger::testFormat(bytes data) {
+  string Logger::testFormat(bytes const& data) {
     auto idx = 0;
     stringstream ss;
     while (idx < data.size()) {
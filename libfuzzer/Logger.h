@@ -1,20 +1,68 @@
 #pragma once
-#include<iostream>
+#include <iostream>
 #include <fstream>
+#include <atomic>
+#include <memory>
 #include "Common.h"
 
 using namespace dev;
 using namespace eth;
 using namespace std;
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_NONE 2
+/* Call sites below this level compile to nothing */
+#ifndef FUZZER_LOG_LEVEL
+#define FUZZER_LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+/* The message is only built when its level is written */
+#define LOG_DEBUG(message) do { \
+  if (FUZZER_LOG_LEVEL <= LOG_LEVEL_DEBUG && fuzzer::Logger::isOn(fuzzer::Logger::DEBUG)) fuzzer::Logger::debug(message); \
+} while (0)
+#define LOG_INFO(message) do { \
+  if (FUZZER_LOG_LEVEL <= LOG_LEVEL_INFO && fuzzer::Logger::isOn(fuzzer::Logger::INFO)) fuzzer::Logger::info(message); \
+} while (0)
+
 namespace fuzzer {
+  /*
+   * Bounded lock free queue of log lines, any thread pushes and the writer
+   * pops. A cell is free again once its sequence moved one lap ahead.
+   */
+  class LogRing {
+    struct Cell {
+      atomic<size_t> sequence;
+      int level;
+      string message;
+    };
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    atomic<size_t> enqueuePos;
+    atomic<size_t> dequeuePos;
+    public:
+      /* Capacity is rounded up to a power of two */
+      LogRing(size_t capacity);
+      /* Returns false when full, the message is dropped */
+      bool push(int level, string &&message);
+      bool pop(int &level, string &message);
+  };
+  /*
+   * Lines are queued by the fuzzing threads and written by a background
+   * thread, debug.txt and info.txt are only flushed when it has nothing to do
+   */
   class Logger {
     public:
-      static bool enabled;
-      static ofstream debugFile;
-      static ofstream infoFile;
-      static void setEnabled(bool _enabled);
+      enum Level { DEBUG = LOG_LEVEL_DEBUG, INFO = LOG_LEVEL_INFO, NONE = LOG_LEVEL_NONE };
+      /* Lowest level written at runtime */
+      static atomic<int> level;
+      static bool isOn(Level l) { return l >= level.load(memory_order_relaxed); }
+      static void setLevel(Level l) { level = l; }
       static void info(string str);
       static void debug(string str);
-      static string testFormat(bytes data);
+      /* Blocks until every queued line is written */
+      static void flush();
+      /* Lines lost because the queue was full */
+      static uint64_t dropped();
+      static string testFormat(bytes const& data);
   };
 }
@@ -1,4 +1,5 @@
 #include <ctime>
+#include <boost/algorithm/string.hpp>
 #include "Mutation.h"
 #include "Dictionary.h"
 #include "Util.h"
@@ -8,17 +9,148 @@
 using namespace std;
 using namespace fuzzer;
 
-uint64_t Mutation::stageCycles[32] = {};
+atomic<uint64_t> Mutation::stageCycles[32];
+
+namespace {
+  /* A value of the test data and what the ABI says about it */
+  struct AbiValue {
+    u32 offset;
+    u32 realLen;
+    string type;
+    bool isAddress;
+    /* Bytes the contract sees, right aligned unless bytes or string */
+    u32 width() const {
+      if (isAddress) return 20;
+      if (boost::starts_with(type, "uint")) return stoi(type.substr(4)) / 8;
+      if (boost::starts_with(type, "int")) return stoi(type.substr(3)) / 8;
+      if (boost::starts_with(type, "bytes") && type.size() > 5) return stoi(type.substr(5));
+      return realLen;
+    }
+    bool padLeft() const {
+      return !boost::starts_with(type, "bytes") && !boost::starts_with(type, "string");
+    }
+    bool isSigned() const { return boost::starts_with(type, "int"); }
+  };
+
+  vector<AbiValue> abiValues(const ContractABI &ca, const bytes &data, u32 &numLens) {
+    vector<AbiValue> values;
+    /* Sender is an address too */
+    values.push_back(AbiValue{32, 32, "uint160", true});
+    u32 offset = 96;
+    numLens = ca.walkTestData(bytes(data.begin(), data.begin() + 32), [&](vector<int> const& path, int realLen, int containerLen) {
+      auto const& td = ca.fds[path[0]].tds[path[1]];
+      if (realLen && offset + containerLen <= data.size()) {
+        values.push_back(AbiValue{offset, (u32) realLen, td.realname.substr(0, td.realname.find('[')), boost::starts_with(td.name, "address")});
+      }
+      offset += containerLen;
+    });
+    return values;
+  }
+
+  /* Low len bytes of a value, big endian as the ABI encodes it */
+  bytes lowBytes(u256 const& value, u32 len) {
+    auto word = h256(value);
+    return bytes(word.begin() + 32 - len, word.end());
+  }
+
+  /* Smallest integer width holding both values */
+  u32 operandWidth(u256 const& a, u256 const& b) {
+    auto top = max(a, b);
+    for (u32 width : {1, 2, 4, 8, 16, 20}) {
+      if (!(top >> (width * 8))) return width;
+    }
+    return 32;
+  }
+
+  /* Fill the unused high bytes of a signed value from its sign bit */
+  void signExtend(bytes &data, const AbiValue &value) {
+    auto width = value.width();
+    if (!value.isSigned() || width >= 32) return;
+    byte fill = data[value.offset + 32 - width] & 0x80 ? 0xFF : 0;
+    memset(data.data() + value.offset, fill, 32 - width);
+  }
+}
 
 Mutation::Mutation(FuzzItem item, Dicts dicts): curFuzzItem(item), dicts(dicts), dataSize(item.data.size()) {
+  live = bytes(dataSize, 1);
+  initEffector();
+  stageName = "init";
+}
+
+Mutation::Mutation(FuzzItem item, Dicts dicts, const ContractABI &ca): Mutation(item, dicts) {
+  loadLayout(ca);
+  /* Reuse what earlier cycles learnt about the same layout */
+  if (item.eff.size() == dataSize) {
+    eff = item.eff;
+    effCount = count(eff.begin(), eff.end(), 1);
+    effKnown = true;
+    updateHotPositions();
+  }
+}
+
+void Mutation::loadLayout(const ContractABI &ca) {
+  slots = ca.readSlots(curFuzzItem.data);
+  live = bytes(dataSize, 0);
+  for (auto const& slot : slots) fill(live.begin() + slot.first, live.begin() + slot.second, 1);
+  updateHotPositions();
+}
+
+void Mutation::initEffector() {
   effCount = 0;
+  effKnown = false;
   eff = bytes(effALen(dataSize), 0);
   eff[0] = 1;
   if (effAPos(dataSize - 1) != 0) {
     eff[effAPos(dataSize - 1)] = 1;
     effCount ++;
   }
-  stageName = "init";
+  updateHotPositions();
+}
+
+void Mutation::alignEffector() {
+  /* A value is worth mutating as a whole or not at all */
+  if (slots.size()) {
+    bytes aligned(dataSize, 0);
+    for (auto const& slot : slots) {
+      if (find(eff.begin() + slot.first, eff.begin() + slot.second, 1) != eff.begin() + slot.second) {
+        fill(aligned.begin() + slot.first, aligned.begin() + slot.second, 1);
+      }
+    }
+    eff = aligned;
+  }
+  effCount = count(eff.begin(), eff.end(), 1);
+  effKnown = true;
+  updateHotPositions();
+}
+
+void Mutation::focus(const Taint &offsets) {
+  focused = bytes(dataSize, 0);
+  for (auto offset : offsets) {
+    if (offset < dataSize && live[offset]) focused[offset] = 1;
+  }
+  if (find(focused.begin(), focused.end(), 1) == focused.end()) focused.clear();
+  updateHotPositions();
+}
+
+void Mutation::updateHotPositions() {
+  auto const& mask = focused.size() ? focused : effKnown && effCount ? eff : live;
+  hotPositions.clear();
+  for (u32 i = 0; i < mask.size(); i ++) {
+    if (mask[i]) hotPositions.push_back(i);
+  }
+}
+
+bool Mutation::skip(u32 pos, u32 len) const {
+  auto const& mask = focused.size() ? focused : effKnown ? eff : live;
+  for (u32 i = pos; i < pos + len && i < mask.size(); i ++) {
+    if (mask[i]) return false;
+  }
+  return true;
+}
+
+u32 Mutation::randomPos(u32 len) {
+  if (hotPositions.empty()) return UR(dataSize - len + 1);
+  return min(hotPositions[UR(hotPositions.size())], (u32) dataSize - len);
 }
 
 void Mutation::flipbit(int pos) {
@@ -28,34 +160,50 @@ void Mutation::flipbit(int pos) {
 void Mutation::singleWalkingBit(OnMutateFunc cb) {
   stageName = "bitflip 1/1";
   stageMax = dataSize << 3;
+  uint64_t skipped = 0;
   /* Start fuzzing */
   for (stageCur = 0; stageCur < stageMax ; stageCur += 1) {
+    /* Bytes which are never read or had no effect so far */
+    if (skip(stageCur >> 3, 1)) {
+      skipped ++;
+      continue;
+    }
     flipbit(stageCur);
     cb(curFuzzItem.data);
     flipbit(stageCur);
   }
-  stageCycles[STAGE_FLIP1] += stageMax;
+  stageCycles[STAGE_FLIP1] += stageMax - skipped;
 }
 
 void Mutation::twoWalkingBit(OnMutateFunc cb) {
   stageName = "bitflip 2/1";
   stageMax = (dataSize << 3) - 1;
+  uint64_t skipped = 0;
   /* Start fuzzing */
   for (stageCur = 0; stageCur < stageMax; stageCur += 1) {
+    if (skip(stageCur >> 3, ((stageCur + 1) >> 3) - (stageCur >> 3) + 1)) {
+      skipped ++;
+      continue;
+    }
     flipbit(stageCur);
     flipbit(stageCur + 1);
     cb(curFuzzItem.data);
     flipbit(stageCur);
     flipbit(stageCur + 1);
   }
-  stageCycles[STAGE_FLIP2] += stageMax;
+  stageCycles[STAGE_FLIP2] += stageMax - skipped;
 }
 
 void Mutation::fourWalkingBit(OnMutateFunc cb) {
   stageName = "bitflip 4/1";
   stageMax = (dataSize << 3) - 3;
+  uint64_t skipped = 0;
   /* Start fuzzing */
   for (stageCur = 0; stageCur < stageMax; stageCur += 1) {
+    if (skip(stageCur >> 3, ((stageCur + 3) >> 3) - (stageCur >> 3) + 1)) {
+      skipped ++;
+      continue;
+    }
     flipbit(stageCur);
     flipbit(stageCur + 1);
     flipbit(stageCur + 2);
@@ -66,14 +214,20 @@ void Mutation::fourWalkingBit(OnMutateFunc cb) {
     flipbit(stageCur + 2);
     flipbit(stageCur + 3);
   }
-  stageCycles[STAGE_FLIP4] += stageMax;
+  stageCycles[STAGE_FLIP4] += stageMax - skipped;
 }
 
 void Mutation::singleWalkingByte(OnMutateFunc cb) {
   stageName = "bitflip 8/8";
   stageMax = dataSize;
+  uint64_t skipped = 0;
   /* Start fuzzing */
   for (stageCur = 0; stageCur < stageMax; stageCur += 1) {
+    /* updateTestData never reads it */
+    if (!live[stageCur]) {
+      skipped ++;
+      continue;
+    }
     curFuzzItem.data[stageCur] ^= 0xFF;
     FuzzItem item = cb(curFuzzItem.data);
     /* We also use this stage to pull off a simple trick: we identify
@@ -91,10 +245,13 @@ void Mutation::singleWalkingByte(OnMutateFunc cb) {
   /* If the effector map is more than EFF_MAX_PERC dense, just flag the
    whole thing as worth fuzzing, since we wouldn't be saving much time
    anyway. */
-  if (effCount != effALen(dataSize) && effCount * 100 / effALen(dataSize) > EFF_MAX_PERC) {
-    eff = bytes(effALen(dataSize), 1);
+  alignEffector();
+  uint64_t numLive = count(live.begin(), live.end(), 1);
+  if (effCount != numLive && effCount * 100 / max(numLive, (uint64_t) 1) > EFF_MAX_PERC) {
+    eff = live;
+    alignEffector();
   }
-  stageCycles[STAGE_FLIP8] += stageMax;
+  stageCycles[STAGE_FLIP8] += stageMax - skipped;
 }
 
 void Mutation::twoWalkingByte(OnMutateFunc cb) {
@@ -105,7 +262,7 @@ void Mutation::twoWalkingByte(OnMutateFunc cb) {
   u8 *buf = curFuzzItem.data.data();
   for (int i = 0; i < dataSize - 1; i += 1) {
     /* Let's consult the effector map... */
-    if (!eff[effAPos(i)] && !eff[effAPos(i + 1)]) {
+    if (skip(i, 2)) {
       stageMax--;
       continue;
     }
@@ -125,8 +282,7 @@ void Mutation::fourWalkingByte(OnMutateFunc cb) {
   u8 *buf = curFuzzItem.data.data();
   for (int i = 0; i < dataSize - 3; i += 1) {
     /* Let's consult the effector map... */
-    if (!eff[effAPos(i)] && !eff[effAPos(i + 1)] &&
-        !eff[effAPos(i + 2)] && !eff[effAPos(i + 3)]) {
+    if (skip(i, 4)) {
       stageMax --;
       continue;
     }
@@ -326,8 +482,7 @@ void Mutation::fourInterest(OnMutateFunc cb) {
   for (int i = 0; i < dataSize - 3; i++) {
     u32 orig = *(u32*)(out_buf + i);
     /* Let's consult the effector map... */
-    if (!eff[effAPos(i)] && !eff[effAPos(i + 1)] &&
-        !eff[effAPos(i + 2)] && !eff[effAPos(i + 3)]) {
+    if (skip(i, 4)) {
       stageMax -= sizeof(INTERESTING_32) >> 1;
       continue;
     }
@@ -357,44 +512,42 @@ void Mutation::fourInterest(OnMutateFunc cb) {
 
 void Mutation::overwriteWithDictionary(OnMutateFunc cb) {
   stageName = "dict (over)";
-  auto dict = get<0>(dicts);
-  stageMax = dataSize * dict.extras.size();
+  auto &codeExtras = get<0>(dicts).extras;
+  auto &runtimeExtras = get<2>(dicts).extras;
+  u32 extrasCount = codeExtras.size() + runtimeExtras.size();
+  stageMax = (dataSize / 32) * extrasCount;
   stageCur = 0;
   /* Start fuzzing */
   byte *outBuf = curFuzzItem.data.data();
   byte inBuf[curFuzzItem.data.size()];
   memcpy(inBuf, outBuf, curFuzzItem.data.size());
-  u32 extrasCount = dict.extras.size();
-  /*
-   * In solidity - data block is 32 bytes then change to step = 32, not 1
-   * Size of extras is alway 32
-   */
-  for (u32 i = 0; i < (u32)dataSize; i += 1) {
-    u32 lastLen = 0;
-    for (u32 j = 0; j < extrasCount; j += 1) {
-      byte *extrasBuf = dict.extras[j].data.data();
-      byte *effBuf = eff.data();
-      u32 extrasLen = dict.extras[j].data.size();
+  /* Values are integers, in solidity a data block is 32 bytes */
+  for (u32 j = 0; j < extrasCount; j += 1) {
+    auto &extra = j < codeExtras.size() ? codeExtras[j] : runtimeExtras[j - codeExtras.size()];
+    byte *extrasBuf = extra.data.data();
+    u32 extrasLen = extra.data.size();
+    for (u32 i = 0; i + 32 <= (u32)dataSize; i += 32) {
+      u32 pos = i + 32 - extrasLen;
       /* Skip extras probabilistically if extras_cnt > MAX_DET_EXTRAS. Also
        skip them if there's no room to insert the payload, if the token
-       is redundant, or if its entire span has no bytes set in the effector
-       map. */
+       is redundant, or if the bytes it covers are not effective */
       if ((extrasCount > MAX_DET_EXTRAS
           && UR(extrasCount) > MAX_DET_EXTRAS)
-          || extrasLen > (dataSize - i)
-          || !memcmp(extrasBuf, outBuf + i, extrasLen)
-          || !memchr(effBuf + effAPos(i), 1, effSpanALen(i, extrasLen))
+          || extrasLen > 32
+          || !memcmp(extrasBuf, outBuf + pos, extrasLen)
+          || skip(pos, extrasLen)
           ) {
         stageMax --;
         continue;
       }
-      lastLen = extrasLen;
-      memcpy(outBuf + i, extrasBuf, lastLen);
-      cb(curFuzzItem.data);
+      memcpy(outBuf + pos, extrasBuf, extrasLen);
+      auto item = cb(curFuzzItem.data);
+      extra.uses ++;
+      if (item.depth) extra.finds ++;
       stageCur ++;
+      /* Restore all the clobbered memory. */
+      memcpy(outBuf + pos, inBuf + pos, extrasLen);
     }
-    /* Restore all the clobbered memory. */
-    memcpy(outBuf + i, inBuf + i, lastLen);
   }
   stageCycles[STAGE_EXTRAS_UO] += stageMax;
 }
@@ -431,39 +584,40 @@ void Mutation::overwriteWithAddressDictionary(OnMutateFunc cb) {
 /*
  * TODO: If found more, do more havoc
  */
-void Mutation::havoc(OnMutateFunc cb) {
+void Mutation::havoc(OnMutateFunc cb, u32 cycles) {
   stageName = "havoc";
-  stageMax = HAVOC_MIN;
+  stageMax = cycles;
   stageCur = 0;
 
-  auto dict = get<0>(dicts);
+  auto const& codeExtras = get<0>(dicts).extras;
+  auto const& runtimeExtras = get<2>(dicts).extras;
+  u32 numExtras = codeExtras.size() + runtimeExtras.size();
   auto origin = curFuzzItem.data;
   bytes data = origin;
-  for (int i = 0; i < HAVOC_MIN; i += 1) {
+  for (u32 i = 0; i < cycles; i += 1) {
     u32 useStacking = 1 << (1 + UR(HAVOC_STACK_POW2));
     for (u32 j = 0; j < useStacking; j += 1) {
-      u32 val = UR(11 + ((dict.extras.size() + 0) ? 2 : 0));
+      u32 val = UR(11 + (numExtras ? 2 : 0));
       dataSize = data.size();
       byte *out_buf = data.data();
       switch (val) {
         case 0: {
           /* Flip a single bit somewhere. Spooky! */
-          u32 pos = UR(dataSize << 3);
-          data[pos >> 3] ^= (128 >> (pos & 7));
+          data[randomPos(1)] ^= (128 >> UR(8));
           break;
         }
         case 1: {
           /* Set byte to interesting value. */
-          data[UR(dataSize)] = INTERESTING_8[UR(sizeof(INTERESTING_8))];
+          data[randomPos(1)] = INTERESTING_8[UR(sizeof(INTERESTING_8))];
           break;
         }
         case 2: {
           /* Set word to interesting value, randomly choosing endian. */
           if (dataSize < 2) break;
           if (UR(2)) {
-            *(u16*)(out_buf + UR(dataSize - 1)) = INTERESTING_16[UR(sizeof(INTERESTING_16) >> 1)];
+            *(u16*)(out_buf + randomPos(2)) = INTERESTING_16[UR(sizeof(INTERESTING_16) >> 1)];
           } else {
-            *(u16*)(out_buf + UR(dataSize - 1)) = swap16(INTERESTING_16[UR(sizeof(INTERESTING_16) >> 1)]);
+            *(u16*)(out_buf + randomPos(2)) = swap16(INTERESTING_16[UR(sizeof(INTERESTING_16) >> 1)]);
           }
           break;
         }
@@ -471,30 +625,30 @@ void Mutation::havoc(OnMutateFunc cb) {
           /* Set dword to interesting value, randomly choosing endian. */
           if (dataSize < 4) break;
           if (UR(2)) {
-            *(u32*)(out_buf + UR(dataSize - 3)) = INTERESTING_32[UR(sizeof(INTERESTING_32) >> 2)];
+            *(u32*)(out_buf + randomPos(4)) = INTERESTING_32[UR(sizeof(INTERESTING_32) >> 2)];
           } else {
-            *(u32*)(out_buf + UR(dataSize - 3)) = swap32(INTERESTING_32[UR(sizeof(INTERESTING_32) >> 2)]);
+            *(u32*)(out_buf + randomPos(4)) = swap32(INTERESTING_32[UR(sizeof(INTERESTING_32) >> 2)]);
           }
           break;
         }
         case 4: {
           /* Randomly subtract from byte. */
-          out_buf[UR(dataSize)] -= 1 + UR(ARITH_MAX);
+          out_buf[randomPos(1)] -= 1 + UR(ARITH_MAX);
           break;
         }
         case 5: {
           /* Randomly add to byte. */
-          out_buf[UR(dataSize)] += 1 + UR(ARITH_MAX);
+          out_buf[randomPos(1)] += 1 + UR(ARITH_MAX);
           break;
         }
         case 6: {
           /* Randomly subtract from word, random endian. */
           if (dataSize < 2) break;
           if (UR(2)) {
-            u32 pos = UR(dataSize - 1);
+            u32 pos = randomPos(2);
             *(u16*)(out_buf + pos) -= 1 + UR(ARITH_MAX);
           } else {
-            u32 pos = UR(dataSize - 1);
+            u32 pos = randomPos(2);
             u16 num = 1 + UR(ARITH_MAX);
             *(u16*)(out_buf + pos) = swap16(swap16(*(u16*)(out_buf + pos)) - num);
           }
@@ -504,10 +658,10 @@ void Mutation::havoc(OnMutateFunc cb) {
           /* Randomly add to word, random endian. */
           if (dataSize < 2) break;
           if (UR(2)) {
-            u32 pos = UR(dataSize - 1);
+            u32 pos = randomPos(2);
             *(u16*)(out_buf + pos) += 1 + UR(ARITH_MAX);
           } else {
-            u32 pos = UR(dataSize - 1);
+            u32 pos = randomPos(2);
             u16 num = 1 + UR(ARITH_MAX);
             *(u16*)(out_buf + pos) = swap16(swap16(*(u16*)(out_buf + pos)) + num);
           }
@@ -517,10 +671,10 @@ void Mutation::havoc(OnMutateFunc cb) {
           /* Randomly subtract from dword, random endian. */
           if (dataSize < 4) break;
           if (UR(2)) {
-            u32 pos = UR(dataSize - 3);
+            u32 pos = randomPos(4);
             *(u32*)(out_buf + pos) -= 1 + UR(ARITH_MAX);
           } else {
-            u32 pos = UR(dataSize - 3);
+            u32 pos = randomPos(4);
             u32 num = 1 + UR(ARITH_MAX);
             *(u32*)(out_buf + pos) = swap32(swap32(*(u32*)(out_buf + pos)) - num);
           }
@@ -530,10 +684,10 @@ void Mutation::havoc(OnMutateFunc cb) {
           /* Randomly add to dword, random endian. */
           if (dataSize < 4) break;
           if (UR(2)) {
-            u32 pos = UR(dataSize - 3);
+            u32 pos = randomPos(4);
             *(u32*)(out_buf + pos) += 1 + UR(ARITH_MAX);
           } else {
-            u32 pos = UR(dataSize - 3);
+            u32 pos = randomPos(4);
             u32 num = 1 + UR(ARITH_MAX);
             *(u32*)(out_buf + pos) = swap32(swap32(*(u32*)(out_buf + pos)) + num);
           }
@@ -543,7 +697,7 @@ void Mutation::havoc(OnMutateFunc cb) {
           /* Just set a random byte to a random value. Because,
            why not. We use XOR with 1-255 to eliminate the
            possibility of a no-op. */
-          out_buf[UR(dataSize)] ^= 1 + UR(255);
+          out_buf[randomPos(1)] ^= 1 + UR(255);
           break;
         }
         case 11: {
@@ -553,7 +707,7 @@ void Mutation::havoc(OnMutateFunc cb) {
           if (dataSize < 2) break;
           copyLen = chooseBlockLen(dataSize - 1);
           copyFrom = UR(dataSize - copyLen + 1);
-          copyTo = UR(dataSize - copyLen + 1);
+          copyTo = randomPos(copyLen);
           if (UR(4)) {
             if (copyFrom != copyTo)
               memmove(out_buf + copyTo, out_buf + copyFrom, copyLen);
@@ -563,13 +717,14 @@ void Mutation::havoc(OnMutateFunc cb) {
           break;
         }
         case 12: {
-          /* No auto extras or odds in our favor. Use the dictionary. */
-          u32 useExtra = UR(dict.extras.size());
-          u32 extraLen = dict.extras[useExtra].data.size();
-          byte *extraBuf = dict.extras[useExtra].data.data();
+          /* No auto extras or odds in our favor. Use the code or runtime dictionary. */
+          u32 useExtra = UR(numExtras);
+          auto const& extra = useExtra < codeExtras.size() ? codeExtras[useExtra] : runtimeExtras[useExtra - codeExtras.size()];
+          u32 extraLen = extra.data.size();
+          const byte *extraBuf = extra.data.data();
           u32 insertAt;
           if (extraLen > (u32)dataSize) break;
-          insertAt = UR(dataSize - extraLen + 1);
+          insertAt = randomPos(extraLen);
           memcpy(out_buf + insertAt, extraBuf, extraLen);
           break;
         }
@@ -583,26 +738,76 @@ void Mutation::havoc(OnMutateFunc cb) {
   stageCycles[STAGE_HAVOC] += stageMax;
 }
 
-bool Mutation::splice(vector<FuzzItem> queues) {
+/* Insert, delete, duplicate and reorder calls of the transaction sequence */
+void Mutation::havocSequence(OnMutateSequenceFunc cb, u32 numFuncs) {
+  stageName = "sequence";
+  stageMax = HAVOC_MIN;
+  stageCur = 0;
+  if (!numFuncs) return;
+  auto origin = curFuzzItem.sequence;
+  if (!origin.size()) {
+    for (u32 i = 0; i < numFuncs; i ++) origin.push_back(i);
+  }
+  Sequence sequence = origin;
+  for (int i = 0; i < HAVOC_MIN; i += 1) {
+    u32 useStacking = 1 << UR(3);
+    for (u32 j = 0; j < useStacking; j += 1) {
+      auto size = sequence.size();
+      switch (UR(4)) {
+        case 0: {
+          /* Insert a random call */
+          if (size >= MAX_SEQUENCE_LENGTH) break;
+          sequence.insert(sequence.begin() + UR(size + 1), UR(numFuncs));
+          break;
+        }
+        case 1: {
+          /* Delete a call, keep at least one */
+          if (size <= 1) break;
+          sequence.erase(sequence.begin() + UR(size));
+          break;
+        }
+        case 2: {
+          /* Call the same function again right after */
+          if (size >= MAX_SEQUENCE_LENGTH) break;
+          auto pos = UR(size);
+          sequence.insert(sequence.begin() + pos, sequence[pos]);
+          break;
+        }
+        case 3: {
+          /* Swap two calls */
+          swap(sequence[UR(size)], sequence[UR(size)]);
+          break;
+        }
+      }
+    }
+    cb(sequence);
+    stageCur ++;
+    /* Restore to original state */
+    sequence = origin;
+  }
+  stageCycles[STAGE_SEQUENCE] += stageMax;
+}
+
+bool Mutation::splice(const vector<TestcaseRef> &queues) {
   u32 spliceCycle = 0;
   s32 firstDiff, lastDiff;
   bytes origin = curFuzzItem.data;
   if (queues.size() <= 1) return false;
-  auto numDiff = count_if(queues.begin(), queues.end(), [&](const FuzzItem &item) {
-    return item.res.cksum != queues[0].res.cksum;
+  auto numDiff = count_if(queues.begin(), queues.end(), [&](const TestcaseRef &testcase) {
+    return testcase->res.cksum != queues[0]->res.cksum;
   });
   if (!numDiff) return false;
   while (spliceCycle++ < SPLICE_CYCLES && curFuzzItem.data.size() > 1) {
     u32 tid, splitAt;
     do {
       tid = UR(queues.size());
-    } while (queues[tid].res.cksum == curFuzzItem.res.cksum);
-    FuzzItem target = queues[tid];
+    } while (queues[tid]->res.cksum == curFuzzItem.res.cksum);
+    auto const& target = *queues[tid];
     /* Find a suitable splicing location, somewhere between the first and
      the last differing byte. Bail out if the difference is just a single
      byte or so. */
     byte *outBuf = curFuzzItem.data.data();
-    byte *targetBuf = target.data.data();
+    const byte *targetBuf = target.data.data();
     u32 minLen = curFuzzItem.data.size() > target.data.size()
     ? target.data.size() : curFuzzItem.data.size();
     locateDiffs(outBuf, targetBuf, minLen, &firstDiff, &lastDiff);
@@ -626,3 +831,257 @@ void Mutation::random(OnMutateFunc cb) {
   cb(curFuzzItem.data);
   stageCycles[STAGE_RANDOM] += stageMax;
 }
+
+bytes Mutation::trim(const ContractABI &ca, OnMutateFunc cb, function<bool (const FuzzItem &)> keeps, bool normalize) {
+  stageName = "trim";
+  stageMax = 0;
+  stageCur = 0;
+  /* Bytes past the last value are never decoded */
+  auto data = ca.resizeTestData(curFuzzItem.data, curFuzzItem.data);
+  auto attempt = [&](const bytes &candidate) {
+    if (candidate == data) return false;
+    stageCur ++;
+    if (!keeps(cb(candidate))) return false;
+    data = candidate;
+    return true;
+  };
+  for (int i = 0; i < 32; i += 1) {
+    byte len = data[i];
+    /* Try the shortest len first, stop at the first one which keeps the path */
+    for (byte shorter : {(byte) 0, (byte) (len / 4), (byte) (len / 2), (byte) (len - 1)}) {
+      if (shorter >= len) continue;
+      bytes lens(data.begin(), data.begin() + 32);
+      lens[i] = shorter;
+      auto candidate = ca.resizeTestData(data, lens);
+      /* The len is not consumed, nothing to shrink */
+      if (candidate.size() == data.size() && equal(candidate.begin() + 32, candidate.end(), data.begin() + 32)) break;
+      if (attempt(candidate)) break;
+    }
+  }
+  if (normalize) {
+    for (size_t pos = 96; pos < data.size(); pos += 32) {
+      auto candidate = data;
+      fill(candidate.begin() + pos, candidate.begin() + min(pos + 32, candidate.size()), 0);
+      attempt(candidate);
+    }
+  }
+  stageMax = stageCur;
+  stageCycles[STAGE_TRIM] += stageCur;
+  /* The inherited effector map still holds if the values kept their place */
+  auto reshaped = data.size() != curFuzzItem.data.size() || !equal(data.begin(), data.begin() + 32, curFuzzItem.data.begin());
+  curFuzzItem.data = data;
+  dataSize = data.size();
+  if (reshaped) {
+    initEffector();
+    loadLayout(ca);
+  }
+  return data;
+}
+
+void Mutation::abiHavoc(const ContractABI &ca, OnMutateFunc cb, u32 cycles) {
+  stageName = "abi havoc";
+  stageMax = cycles;
+  stageCur = 0;
+  auto addressDict = get<1>(dicts);
+  auto origin = curFuzzItem.data;
+  for (u32 i = 0; i < cycles; i += 1) {
+    bytes data = origin;
+    u32 useStacking = 1 << UR(3);
+    for (u32 j = 0; j < useStacking; j += 1) {
+      u32 numLens = 0;
+      auto values = abiValues(ca, data, numLens);
+      auto const& value = values[UR(values.size())];
+      auto width = min(value.width(), value.realLen);
+      auto start = value.padLeft() ? value.offset + 32 - width : value.offset;
+      switch (UR(4)) {
+        case 0: {
+          /* Flip a bit the contract actually reads */
+          if (!width) break;
+          u32 pos = start + UR(width);
+          data[pos] ^= 128 >> UR(8);
+          signExtend(data, value);
+          break;
+        }
+        case 1: {
+          /* Boundary value of the type */
+          if (!value.padLeft()) {
+            memset(data.data() + start, UR(2) ? 0xFF : 0, width);
+            break;
+          }
+          u32 bits = width * 8;
+          u256 top = bits >= 256 ? ~u256(0) : (u256(1) << bits) - 1;
+          u256 half = u256(1) << (bits - 1);
+          vector<u256> boundaries = value.isSigned()
+            ? vector<u256>{0, 1, ~u256(0), half - 1, half - 2, u256(0) - half, u256(0) - half + 1}
+            : vector<u256>{0, 1, top, top - 1, half, half - 1};
+          auto word = h256(boundaries[UR(boundaries.size())]);
+          /* Keep the balance which shares the word of the sender */
+          auto isSender = value.offset == 32;
+          auto from = isSender ? 12 : 0;
+          copy(word.begin() + from, word.end(), data.begin() + value.offset + from);
+          if (!isSender && !value.isSigned() && bits < 256) memset(data.data() + value.offset, 0, 32 - width);
+          break;
+        }
+        case 2: {
+          /* Resize a dynamic value or array, other values keep their place */
+          if (!numLens) break;
+          bytes lens(data.begin(), data.begin() + 32);
+          auto &len = lens[UR(min(numLens, (u32) 32))];
+          len = UR(4) ? (UR(2) && len < 255 ? len + 1 : (len ? len - 1 : 1)) : 0;
+          data = ca.resizeTestData(data, lens);
+          break;
+        }
+        case 3: {
+          /* Known address */
+          if (!value.isAddress || !addressDict.extras.size()) break;
+          auto const& address = addressDict.extras[UR(addressDict.extras.size())].data;
+          copy(address.begin(), address.end(), data.begin() + value.offset + 12);
+          break;
+        }
+      }
+    }
+    /* Only distinct calls are worth an execution */
+    if (data == origin) {
+      stageMax --;
+      continue;
+    }
+    cb(data);
+    stageCur ++;
+  }
+  stageCycles[STAGE_ABI] += stageMax;
+}
+
+void Mutation::inputToState(const vector<Comparison> &comparisons, OnMutateFunc cb) {
+  stageName = "input to state";
+  stageCur = 0;
+  auto origin = curFuzzItem.data;
+  set<bytes> tried;
+  vector<bytes> candidates;
+  auto patch = [&](bytes const& from, bytes const& to, bool wordEnd) {
+    for (u32 pos = 0; pos + from.size() <= dataSize; pos ++) {
+      if (wordEnd && (pos + from.size()) % 32) continue;
+      if (!equal(from.begin(), from.end(), origin.begin() + pos)) continue;
+      bytes data = origin;
+      copy(to.begin(), to.end(), data.begin() + pos);
+      if (tried.insert(data).second) candidates.push_back(data);
+    }
+  };
+  auto patchValue = [&](u256 const& from, u256 const& target) {
+    auto width = operandWidth(from, target);
+    auto needle = lowBytes(from, width);
+    auto value = lowBytes(target, width);
+    /* Short values match anywhere, keep the ones right aligned in a word */
+    patch(needle, value, width < 4);
+    if (width < 4) return;
+    reverse(needle.begin(), needle.end());
+    reverse(value.begin(), value.end());
+    patch(needle, value, false);
+  };
+  /* Words loaded from calldata, an operand a few units off one of them was computed from it */
+  vector<u256> loaded;
+  for (auto const& comparison : comparisons) {
+    if (comparison.inst == Instruction::CALLDATALOAD && comparison.left) loaded.push_back(comparison.left);
+  }
+  for (auto const& comparison : comparisons) {
+    if (comparison.inst == Instruction::CALLDATALOAD) continue;
+    /* Either operand may come from the data, a hash may stand for the word it hashes */
+    for (auto swapped : {false, true}) {
+      auto const& from = swapped ? comparison.right : comparison.left;
+      auto const& to = swapped ? comparison.left : comparison.right;
+      /* Orderings flip on the neighbours of the other operand */
+      vector<u256> targets = {to};
+      if (comparison.inst != Instruction::EQ && comparison.inst != Instruction::SHA3) targets = {to, to + 1, to - 1};
+      for (auto const& target : targets) {
+        if (target == from) continue;
+        patchValue(from, target);
+        if (comparison.inst == Instruction::SHA3) continue;
+        for (auto const& word : loaded) {
+          u256 delta = from - word;
+          if (!delta || (delta > ARITH_MAX && u256(0) - delta > ARITH_MAX)) continue;
+          patchValue(word, target - delta);
+        }
+      }
+    }
+  }
+  stageMax = candidates.size();
+  for (auto const& data : candidates) {
+    cb(data);
+    stageCur ++;
+  }
+  stageCycles[STAGE_I2S] += stageMax;
+}
+
+void Mutation::localSearch(OnMutateFunc cb, function<u256 (const FuzzItem &)> distance, u256 const& initialDistance, u32 budget) {
+  stageName = "local search";
+  stageMax = budget;
+  stageCur = 0;
+  /* Lens reshape the data, every other value is a variable */
+  vector<pair<int, int>> vars;
+  for (auto const& slot : slots) {
+    if (slot.first < 32) continue;
+    /* Values known not to feed the target */
+    if (focused.size() && find(focused.begin() + slot.first, focused.begin() + slot.second, 1) == focused.begin() + slot.second) continue;
+    vars.push_back(make_pair(slot.first, min(slot.second, slot.first + 32)));
+  }
+  if (slots.empty()) {
+    for (int i = 96; i + 32 <= (int) dataSize; i += 32) vars.push_back(make_pair(i, i + 32));
+  }
+  auto read = [](bytes const& data, pair<int, int> const& var) {
+    return fromBigEndian<u256>(bytesConstRef(data.data() + var.first, var.second - var.first));
+  };
+  /* Wraps within the width of the value */
+  auto write = [](bytes &data, pair<int, int> const& var, u256 const& value) {
+    auto out = bytesRef(data.data() + var.first, var.second - var.first);
+    toBigEndian(value, out);
+  };
+  auto execute = [&](bytes const& data) {
+    stageCur ++;
+    return distance(cb(data));
+  };
+  auto best = curFuzzItem.data;
+  auto bestDistance = initialDistance;
+  bool improved = true;
+  while (improved && bestDistance && stageCur < budget) {
+    improved = false;
+    for (auto const& var : vars) {
+      if (!bestDistance || stageCur >= budget) break;
+      /* Exploratory moves, skip values the distance does not depend on */
+      bool up = false;
+      bool moved = false;
+      for (auto direction : {true, false}) {
+        if (stageCur >= budget) break;
+        auto data = best;
+        auto value = read(best, var);
+        write(data, var, direction ? value + 1 : value - 1);
+        auto dist = execute(data);
+        if (dist < bestDistance) {
+          best = data;
+          bestDistance = dist;
+          up = direction;
+          moved = true;
+          break;
+        }
+      }
+      if (!moved) continue;
+      improved = true;
+      /* Pattern moves */
+      u256 step = 2;
+      while (bestDistance && stageCur < budget) {
+        auto data = best;
+        auto value = read(best, var);
+        write(data, var, up ? value + step : value - step);
+        auto dist = execute(data);
+        if (dist < bestDistance) {
+          best = data;
+          bestDistance = dist;
+          step *= 2;
+          continue;
+        }
+        if (step == 1) break;
+        step = 1;
+      }
+    }
+  }
+  stageMax = stageCur;
+  stageCycles[STAGE_SEARCH] += stageCur;
+}
@@ -1,29 +1,56 @@
 #pragma once
 #include <vector>
+#include <atomic>
 #include "Common.h"
 #include "TargetContainer.h"
 #include "Dictionary.h"
 #include "FuzzItem.h"
+#include "TestcaseStore.h"
 
 using namespace dev;
 using namespace eth;
 using namespace std;
 
 namespace fuzzer {
-  using Dicts = tuple<Dictionary/* code */, Dictionary/* address */>;
+  using Dicts = tuple<Dictionary/* code */, Dictionary/* address */, Dictionary/* runtime */>;
   class Mutation {
     FuzzItem curFuzzItem;
     Dicts dicts;
     uint64_t effCount = 0;
+    /* One flag per byte: bytes whose flip changed the path */
     bytes eff;
+    /* Whether eff comes from a bitflip 8/8 stage, here or in an earlier cycle */
+    bool effKnown = false;
+    /* One flag per byte: bytes read by updateTestData */
+    bytes live;
+    vector<pair<int, int>> slots;
+    /* One flag per byte: bytes feeding the target predicate, empty if unknown */
+    bytes focused;
+    /* Havoc positions: effective bytes once known, live bytes before */
+    vector<u32> hotPositions;
     void flipbit(int pos);
+    void initEffector();
+    void loadLayout(const ContractABI &ca);
+    void alignEffector();
+    void updateHotPositions();
+    bool skip(u32 pos, u32 len) const;
+    u32 randomPos(u32 len);
     public:
       uint64_t dataSize = 0;
       uint64_t stageMax = 0;
       uint64_t stageCur = 0;
       string stageName = "";
-      static uint64_t stageCycles[32];
+      static atomic<uint64_t> stageCycles[32];
       Mutation(FuzzItem item, Dicts dicts);
+      /* Aligns the effector map to the values of the ABI */
+      Mutation(FuzzItem item, Dicts dicts, const ContractABI &ca);
+      /* Effector map worth keeping in the item, empty before bitflip 8/8 */
+      bytes effector() const { return effKnown ? eff : bytes(); }
+      /* Restrict bit flips and havoc positions to the live bytes among offsets */
+      void focus(const Taint &offsets);
+      /* Runtime values with the uses and finds of overwriteWithDictionary */
+      const Dictionary &runtimeDictionary() const { return get<2>(dicts); }
+      void setRuntimeDictionary(const Dictionary &dict) { get<2>(dicts) = dict; }
       void singleWalkingBit(OnMutateFunc cb);
       void twoWalkingBit(OnMutateFunc cb);
       void fourWalkingBit(OnMutateFunc cb);
@@ -37,9 +64,35 @@ namespace fuzzer {
       void twoInterest(OnMutateFunc cb);
       void fourInterest(OnMutateFunc cb);
       void overwriteWithAddressDictionary(OnMutateFunc cb);
+      /* Code constants then runtime values right aligned in every word, items the fuzzer kept come back with their depth set */
       void overwriteWithDictionary(OnMutateFunc cb);
       void random(OnMutateFunc cb);
-      void havoc(OnMutateFunc cb);
-      bool splice(vector<FuzzItem> items);
+      void havoc(OnMutateFunc cb, u32 cycles = HAVOC_MIN);
+      void havocSequence(OnMutateSequenceFunc cb, u32 numFuncs);
+      /* Havoc on decoded values: bits within a value's width, type boundaries, lens and addresses */
+      void abiHavoc(const ContractABI &ca, OnMutateFunc cb, u32 cycles = HAVOC_MIN);
+      /*
+       * Patch operands of logged comparisons found in the data with the other
+       * operand, ±1 and byte swapped. Hashes are swapped with the word they
+       * hash, calldata words a few units off an operand take the other operand
+       * minus that offset
+       */
+      void inputToState(const vector<Comparison> &comparisons, OnMutateFunc cb);
+      /*
+       * Alternating variable search on the values of the ABI, 32 bytes words
+       * without a layout: values whose neighbours lower distance() are walked
+       * in that direction with doubling steps, restarting at unit steps after
+       * an overshoot. Stops once the distance is 0 or after budget executions.
+       * initialDistance is the distance of the current item, known from its
+       * stored result so that it is not executed again
+       */
+      void localSearch(OnMutateFunc cb, function<u256 (const FuzzItem &)> distance, u256 const& initialDistance, u32 budget = SEARCH_MAX);
+      bool splice(const vector<TestcaseRef> &queues);
+      /*
+       * Shrink dynamic lens, then zero 32 bytes blocks if normalize, keeping
+       * only candidates for which keeps() holds. Returns the trimmed data,
+       * later stages mutate it
+       */
+      bytes trim(const ContractABI &ca, OnMutateFunc cb, function<bool (const FuzzItem &)> keeps, bool normalize = false);
   };
 }
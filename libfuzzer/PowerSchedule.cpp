@@ -0,0 +1,49 @@
+#include <cmath>
+#include "PowerSchedule.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  static double MIN_ENERGY = 1.0 / 16;
+  static double MAX_ENERGY = 16;
+
+  namespace {
+    /* Rare branches get exponentially more energy each time they are picked */
+    double fastEnergy(const BranchStats &stats, double averageHits) {
+      double rarity = max(averageHits, 1.0) / max((double) stats.hits, 1.0);
+      return pow(2.0, (double) min(stats.selected, (uint64_t) 8)) * rarity;
+    }
+  }
+
+  double leaderEnergy(PowerSchedule schedule, u256 const& comparisonValue, const BranchStats &stats, double averageHits, double averageExecCost) {
+    /* Cheaper leaders get more havoc, like the perf score of AFL */
+    double energy = 1;
+    if (stats.execCost > 0 && averageExecCost > 0) {
+      energy = min(max(averageExecCost / stats.execCost, 0.25), 3.0);
+    }
+    switch (schedule) {
+      case EXPLOIT: break;
+      case COE: {
+        if (stats.hits > averageHits) return 0;
+        /* Rare branches are scheduled like FAST */
+        energy *= fastEnergy(stats, averageHits);
+        break;
+      }
+      case FAST: {
+        energy *= fastEnergy(stats, averageHits);
+        break;
+      }
+      case DISTANCE: {
+        if (!comparisonValue) break;
+        /* Bits of distance left and bits already gained since the first leader */
+        double remainingBits = (double) msb(comparisonValue) + 1;
+        double initialBits = stats.initialValue ? (double) msb(stats.initialValue) + 1 : remainingBits;
+        double gainedBits = max(initialBits - remainingBits, 0.0);
+        energy *= (1 + gainedBits) * 16 / (16 + remainingBits);
+        break;
+      }
+    }
+    return min(max(energy, MIN_ENERGY), MAX_ENERGY);
+  }
+}
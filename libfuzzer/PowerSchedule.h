@@ -0,0 +1,19 @@
+#pragma once
+#include "Common.h"
+#include "Frontier.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  /*
+   * How leaders are picked and how long they are fuzzed.
+   * EXPLOIT: round-robin, havoc scaled by exec cost only
+   * FAST: rarely reached branches get exponentially more energy each pick
+   * COE: like FAST but skips branches reached more often than average
+   * DISTANCE: leaders whose comparison value keeps dropping get more energy
+   */
+  enum PowerSchedule { EXPLOIT, FAST, COE, DISTANCE };
+  /* Energy of a leader relative to an average one, 0 means skip it */
+  double leaderEnergy(PowerSchedule schedule, u256 const& comparisonValue, const BranchStats &stats, double averageHits, double averageExecCost);
+}
@@ -0,0 +1,55 @@
+#include "SnapshotTrie.h"
+
+using namespace dev;
+using namespace eth;
+using namespace std;
+using namespace fuzzer;
+
+static size_t SEEN_MAX = 1 << 16;
+
+size_t PrefixRecord::memory() const {
+  size_t ret = sizeof(PrefixRecord) + snapshot.state.cacheMemory();
+  ret += tracebits.size() * sizeof(BranchId);
+  ret += predicates.size() * sizeof(pair<BranchId, u256>);
+  ret += uniqExceptions.size() * sizeof(uint64_t);
+  return ret;
+}
+
+h256 SnapshotTrie::childKey(h256 const& parent, bytes const& call) {
+  bytes key = parent.asBytes();
+  key.insert(key.end(), call.begin(), call.end());
+  return sha3(key);
+}
+
+PrefixRecord *SnapshotTrie::find(h256 const& key) {
+  auto it = records.find(key);
+  if (it == records.end()) return nullptr;
+  /* Move to the most recently used end */
+  lru.splice(lru.end(), lru, it->second.position);
+  return &it->second.record;
+}
+
+bool SnapshotTrie::wanted(h256 const& key) {
+  if (records.count(key)) return false;
+  if (seen.count(key)) return true;
+  if (seen.size() >= SEEN_MAX) seen.clear();
+  seen.insert(key);
+  return false;
+}
+
+void SnapshotTrie::insert(h256 const& key, function<PrefixRecord ()> build) {
+  if (records.count(key)) return;
+  auto record = build();
+  auto size = record.memory();
+  if (size > budget) return;
+  seen.erase(key);
+  while (used + size > budget) {
+    auto it = records.find(lru.front());
+    used -= it->second.memory;
+    records.erase(it);
+    lru.pop_front();
+  }
+  used += size;
+  lru.push_back(key);
+  records.insert(make_pair(key, Entry{move(record), prev(lru.end()), size}));
+}
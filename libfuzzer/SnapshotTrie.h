@@ -0,0 +1,59 @@
+#pragma once
+#include <functional>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <liboracle/Common.h>
+#include "CoverageMap.h"
+#include "TargetProgram.h"
+
+using namespace dev;
+using namespace eth;
+using namespace std;
+
+namespace fuzzer {
+  /* Everything an execution reported up to the end of a prefix of its calls */
+  struct PrefixRecord {
+    ProgramSnapshot snapshot;
+    vector<BranchId> tracebits;
+    vector<pair<BranchId, u256>> predicates;
+    uint64_t cksum;
+    unordered_set<uint64_t> uniqExceptions;
+    /* Oracles found by the calls of the prefix, the constructor included */
+    Findings findings;
+    u256 lastCompValue;
+    size_t memory() const;
+  };
+  /*
+   * Snapshots of call prefixes. The key of a prefix chains the key of its
+   * parent with the call data, so every node of the trie is found with one
+   * hashed lookup. Least recently used prefixes are evicted once the
+   * estimated memory exceeds the budget. Most prefixes are never executed
+   * twice, so a prefix is only worth a snapshot the second time it is seen.
+   */
+  class SnapshotTrie {
+    size_t budget;
+    size_t used = 0;
+    struct Entry {
+      PrefixRecord record;
+      list<h256>::iterator position;
+      size_t memory;
+    };
+    list<h256> lru;
+    unordered_map<h256, Entry> records;
+    /* Prefixes seen once, cleared when it grows too large */
+    unordered_set<h256> seen;
+    public:
+      SnapshotTrie(size_t budget): budget(budget) {}
+      static h256 childKey(h256 const& parent, bytes const& call);
+      /* Returns nullptr if the prefix is not cached, valid until next insert */
+      PrefixRecord *find(h256 const& key);
+      /* False for a cached prefix and for the first sighting of a prefix */
+      bool wanted(h256 const& key);
+      /* build only runs if the prefix is not cached yet */
+      void insert(h256 const& key, function<PrefixRecord ()> build);
+      size_t size() const { return records.size(); }
+      size_t memory() const { return used; }
+  };
+}
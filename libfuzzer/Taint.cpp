@@ -0,0 +1,195 @@
+#include <algorithm>
+#include "Taint.h"
+
+namespace fuzzer {
+  namespace {
+    bool outOfLimit(u256 const& offset, u256 const& size) {
+      return offset > MEMORY_LIMIT || size > MEMORY_LIMIT || offset + size > MEMORY_LIMIT;
+    }
+
+    /* Labels of the test data bytes [from, to) */
+    Taint range(u32 from, u32 to) {
+      Taint ret;
+      for (u32 i = from; i < to; i ++) ret.push_back(i);
+      return ret;
+    }
+  }
+
+  void TaintTracker::merge(Taint &into, Taint const& from) {
+    if (from.empty()) return;
+    if (into.empty()) {
+      into = from;
+      return;
+    }
+    Taint ret;
+    set_union(into.begin(), into.end(), from.begin(), from.end(), back_inserter(ret));
+    into.swap(ret);
+  }
+
+  Taint TaintTracker::readMemory(Frame const& frame, u256 const& offset, u256 const& size) const {
+    Taint ret;
+    if (outOfLimit(offset, size)) return ret;
+    for (u64 i = (u64) offset; i < (u64) (offset + size); i ++) {
+      auto it = frame.memory.find(i);
+      if (it != frame.memory.end()) merge(ret, it->second);
+    }
+    return ret;
+  }
+
+  vector<Taint> TaintTracker::memoryBytes(Frame const& frame, u256 const& offset, u256 const& size) const {
+    vector<Taint> ret;
+    if (outOfLimit(offset, size)) return ret;
+    for (u64 i = (u64) offset; i < (u64) (offset + size); i ++) {
+      auto it = frame.memory.find(i);
+      ret.push_back(it == frame.memory.end() ? Taint() : it->second);
+    }
+    return ret;
+  }
+
+  void TaintTracker::writeMemory(Frame &frame, u256 const& offset, u256 const& size, vector<Taint> const& labels, u256 const& from) {
+    if (outOfLimit(offset, size)) return;
+    for (u64 i = 0; i < (u64) size; i ++) {
+      auto source = from + i;
+      auto key = (u64) offset + i;
+      if (source < labels.size() && !labels[(size_t) source].empty()) frame.memory[key] = labels[(size_t) source];
+      else frame.memory.erase(key);
+    }
+  }
+
+  void TaintTracker::begin(vector<int> const& calldata) {
+    frames.assign(1, Frame());
+    for (auto offset : calldata) frames[0].calldata.push_back(offset < 0 ? Taint() : Taint{(u32) offset});
+    returned.clear();
+    pendingCalldata.clear();
+  }
+
+  void TaintTracker::step(u64 pc, Instruction inst, LegacyVM const* vm, ExtVMFace const* ext) {
+    if (frames.empty()) return;
+    size_t depth = ext->depth;
+    /* Callees which returned since the last step */
+    if (frames.size() > depth + 1) frames.resize(depth + 1);
+    while (frames.size() < depth + 1) {
+      frames.push_back(Frame());
+      frames.back().calldata.swap(pendingCalldata);
+    }
+    auto &frame = frames.back();
+    if (frame.calling) {
+      writeMemory(frame, frame.outOffset, frame.outSize, returned);
+      frame.calling = false;
+      pendingCalldata.clear();
+    }
+    /* Realign after an instruction failed */
+    auto &stack = frame.stack;
+    stack.resize(vm->stackSize());
+    auto top = [&](size_t i) -> Taint& { return stack[stack.size() - 1 - i]; };
+    auto info = instructionInfo(inst);
+    if ((int) stack.size() < info.args) return;
+    if (inst >= Instruction::DUP1 && inst <= Instruction::DUP16) {
+      auto copy = top((size_t) inst - (size_t) Instruction::DUP1);
+      stack.push_back(copy);
+      return;
+    }
+    if (inst >= Instruction::SWAP1 && inst <= Instruction::SWAP16) {
+      swap(top(0), top((size_t) inst - (size_t) Instruction::SWAP1 + 1));
+      return;
+    }
+    Taint result;
+    switch (inst) {
+      case Instruction::CALLDATALOAD: {
+        auto offset = vm->stackTop(0);
+        for (u256 i = offset; i < offset + 32 && i < frame.calldata.size(); i ++) merge(result, frame.calldata[(size_t) i]);
+        break;
+      }
+      case Instruction::CALLDATACOPY: {
+        writeMemory(frame, vm->stackTop(0), vm->stackTop(2), frame.calldata, vm->stackTop(1));
+        break;
+      }
+      case Instruction::RETURNDATACOPY: {
+        writeMemory(frame, vm->stackTop(0), vm->stackTop(2), returned, vm->stackTop(1));
+        break;
+      }
+      case Instruction::CODECOPY: {
+        writeMemory(frame, vm->stackTop(0), vm->stackTop(2), vector<Taint>());
+        break;
+      }
+      case Instruction::EXTCODECOPY: {
+        writeMemory(frame, vm->stackTop(1), vm->stackTop(3), vector<Taint>());
+        break;
+      }
+      case Instruction::MLOAD: {
+        result = readMemory(frame, vm->stackTop(0), 32);
+        break;
+      }
+      case Instruction::MSTORE: {
+        writeMemory(frame, vm->stackTop(0), 32, vector<Taint>(32, top(1)));
+        break;
+      }
+      case Instruction::MSTORE8: {
+        writeMemory(frame, vm->stackTop(0), 1, vector<Taint>(1, top(1)));
+        break;
+      }
+      case Instruction::SHA3: {
+        result = readMemory(frame, vm->stackTop(0), vm->stackTop(1));
+        break;
+      }
+      case Instruction::SLOAD: {
+        auto it = storage.find(make_pair(ext->myAddress, vm->stackTop(0)));
+        if (it != storage.end()) result = it->second;
+        break;
+      }
+      case Instruction::SSTORE: {
+        auto key = make_pair(ext->myAddress, vm->stackTop(0));
+        if (top(1).empty()) storage.erase(key);
+        else storage[key] = top(1);
+        break;
+      }
+      /* Balance, sender, block number and timestamp come from the test data */
+      case Instruction::CALLER:
+      case Instruction::ORIGIN: {
+        if (!depth) result = range(44, 64);
+        break;
+      }
+      case Instruction::CALLVALUE: {
+        if (!depth) result = range(32, 44);
+        break;
+      }
+      case Instruction::NUMBER: {
+        result = range(64, 72);
+        break;
+      }
+      case Instruction::TIMESTAMP: {
+        result = range(72, 80);
+        break;
+      }
+      case Instruction::CALL:
+      case Instruction::CALLCODE:
+      case Instruction::DELEGATECALL:
+      case Instruction::STATICCALL: {
+        auto withValue = inst == Instruction::CALL || inst == Instruction::CALLCODE;
+        auto inOff = withValue ? 3 : 2;
+        pendingCalldata = memoryBytes(frame, vm->stackTop(inOff), vm->stackTop(inOff + 1));
+        frame.calling = true;
+        frame.outOffset = vm->stackTop(inOff + 2);
+        frame.outSize = vm->stackTop(inOff + 3);
+        returned.clear();
+        break;
+      }
+      case Instruction::RETURN:
+      case Instruction::REVERT: {
+        returned = memoryBytes(frame, vm->stackTop(0), vm->stackTop(1));
+        break;
+      }
+      case Instruction::JUMPI:
+      case Instruction::JUMPCI: {
+        merge(conditions[pc], top(1));
+        break;
+      }
+      default: {
+        for (int i = 0; i < info.args; i ++) merge(result, top(i));
+        break;
+      }
+    }
+    stack.resize(stack.size() - info.args);
+    for (int i = 0; i < info.ret; i ++) stack.push_back(result);
+  }
+}
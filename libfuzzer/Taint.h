@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <libevm/LegacyVM.h>
+#include "Common.h"
+#include "Util.h"
+
+using namespace dev;
+using namespace eth;
+using namespace std;
+
+namespace fuzzer {
+  /* Sorted test data offsets a value depends on */
+  using Taint = vector<u32>;
+  /*
+   * Byte level taint of one execution, fed by the exec hook with every
+   * instruction hooked. Keeps a shadow stack, memory and calldata per call
+   * frame and a shadow storage per contract. Labels are test data offsets,
+   * so storage written by a call still names the bytes which fed it in the
+   * calls after
+   */
+  class TaintTracker {
+    struct Frame {
+      vector<Taint> stack;
+      unordered_map<u64, Taint> memory;
+      vector<Taint> calldata;
+      /* Output region of the pending call, written once the callee returns */
+      bool calling = false;
+      u256 outOffset;
+      u256 outSize;
+    };
+    vector<Frame> frames;
+    map<pair<Address, u256>, Taint> storage;
+    /* Data of the last RETURN or REVERT */
+    vector<Taint> returned;
+    vector<Taint> pendingCalldata;
+    unordered_map<u64, Taint> conditions;
+    Taint readMemory(Frame const& frame, u256 const& offset, u256 const& size) const;
+    vector<Taint> memoryBytes(Frame const& frame, u256 const& offset, u256 const& size) const;
+    void writeMemory(Frame &frame, u256 const& offset, u256 const& size, vector<Taint> const& labels, u256 const& from = 0);
+    public:
+      static void merge(Taint &into, Taint const& from);
+      /* New transaction, calldata holds the test data offset of every byte or -1 */
+      void begin(vector<int> const& calldata);
+      /* Propagate labels through the instruction about to run */
+      void step(u64 pc, Instruction inst, LegacyVM const* vm, ExtVMFace const* ext);
+      /* Labels of the condition of every JUMPI executed, by pc */
+      unordered_map<u64, Taint> const& jumpis() const { return conditions; }
+  };
+}
@@ -11,8 +11,8 @@ using namespace fuzzer;
 using namespace boost::multiprecision;
 
 namespace fuzzer {
-  TargetContainer::TargetContainer() {
-    program = new TargetProgram();
+  TargetContainer::TargetContainer(StateBackend backend) {
+    program = new TargetProgram(backend);
     oracleFactory = new OracleFactory();
     baseAddress = ATTACKER_ADDRESS;
   }
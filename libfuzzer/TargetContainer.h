@@ -13,7 +13,7 @@ namespace fuzzer {
     OracleFactory *oracleFactory;
     u160 baseAddress;
     public:
-      TargetContainer();
+      TargetContainer(StateBackend backend = FLAT_STATE);
       ~TargetContainer();
       vector<bool> analyze() { return oracleFactory->analyze(); }
       TargetExecutive loadContract(bytes code, ContractABI ca);
@@ -3,10 +3,10 @@
 namespace fuzzer {
 
   TargetContainerResult::TargetContainerResult(
-    unordered_set<string> tracebits,
-    unordered_map<string, u256> predicates,
-    unordered_set<string> uniqExceptions,
-    string cksum
+    vector<BranchId> tracebits,
+    vector<pair<BranchId, u256>> predicates,
+    unordered_set<uint64_t> uniqExceptions,
+    uint64_t cksum
   ) {
     this->tracebits = tracebits;
     this->cksum = cksum;
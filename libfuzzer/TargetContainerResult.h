@@ -2,6 +2,7 @@
 #include <vector>
 #include <map>
 #include "Common.h"
+#include "CoverageMap.h"
 
 using namespace dev;
 using namespace eth;
@@ -11,19 +12,19 @@ namespace fuzzer {
   struct TargetContainerResult {
     TargetContainerResult() {}
     TargetContainerResult(
-        unordered_set<string> tracebits,
-        unordered_map<string, u256> predicates,
-        unordered_set<string> uniqExceptions,
-        string cksum
+        vector<BranchId> tracebits,
+        vector<pair<BranchId, u256>> predicates,
+        unordered_set<uint64_t> uniqExceptions,
+        uint64_t cksum
     );
 
     /* Contains execution paths */
-    unordered_set<string> tracebits;
+    vector<BranchId> tracebits;
     /* Save predicates */
-    unordered_map<string, u256> predicates;
+    vector<pair<BranchId, u256>> predicates;
     /* Exception path */
-    unordered_set<string> uniqExceptions;
-    /* Contains checksum of tracebits */
-    string cksum;
+    unordered_set<uint64_t> uniqExceptions;
+    /* Rolling hash of tracebits in order of first hit */
+    uint64_t cksum = 0;
   };
 }
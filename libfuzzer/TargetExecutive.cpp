@@ -2,6 +2,42 @@
 #include "Logger.h"
 
 namespace fuzzer {
+  namespace {
+    /* Instructions hooked on this thread during an exec, restored however it leaves */
+    struct HookedInstructionsGuard {
+      bitset<256> previous;
+      HookedInstructionsGuard(bitset<256> const& hooked): previous(LegacyVM::hookedInstructions) {
+        LegacyVM::hookedInstructions = hooked;
+      }
+      ~HookedInstructionsGuard() { LegacyVM::hookedInstructions = previous; }
+    };
+  }
+
+  /* Oracles, comparisons, valid jumpis and the instructions which may end a call with an exception */
+  bitset<256> TargetExecutive::defaultHookedInstructions() {
+    bitset<256> hooked;
+    for (auto inst: {
+      Instruction::CALL, Instruction::CALLCODE, Instruction::DELEGATECALL, Instruction::STATICCALL,
+      Instruction::SUICIDE, Instruction::NUMBER, Instruction::TIMESTAMP, Instruction::INVALID,
+      Instruction::ADD, Instruction::SUB,
+      Instruction::GT, Instruction::SGT, Instruction::LT, Instruction::SLT, Instruction::EQ,
+      Instruction::JUMPCI, Instruction::JUMPI, Instruction::JUMP, Instruction::REVERT
+    }) hooked.set((size_t) inst);
+    return hooked;
+  }
+
+  /* Constructor only depends on its arguments, the accounts and the block */
+  h256 TargetExecutive::constructorKey() {
+    bytes key = ca.encodeConstructor();
+    for (auto account : ca.decodeAccounts()) {
+      auto accountInBytes = get<0>(account);
+      key.insert(key.end(), accountInBytes.begin(), accountInBytes.end());
+    }
+    auto blockInBytes = get<0>(ca.decodeBlock());
+    key.insert(key.end(), blockInBytes.begin(), blockInBytes.end());
+    return sha3(key);
+  }
+
   void TargetExecutive::deploy(bytes data, OnOpFunc onOp) {
     ca.updateTestData(data);
     program->deploy(addr, bytes{code});
@@ -10,47 +46,122 @@ namespace fuzzer {
     program->invoke(addr, CONTRACT_CONSTRUCTOR, ca.encodeConstructor(), ca.isPayable(""), onOp);
   }
 
-  TargetContainerResult TargetExecutive::exec(bytes data, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>>& validJumpis) {
+  TargetContainerResult TargetExecutive::exec(bytes data, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>>& validJumpis, const Sequence &sequence) {
     /* Save all hit branches to trace_bits */
-    Instruction prevInst;
     RecordParam recordParam;
     u256 lastCompValue = 0;
-    u64 jumpDest1 = 0;
-    u64 jumpDest2 = 0;
-    unordered_set<string> uniqExceptions;
-    unordered_set<string> tracebits;
-    unordered_map<string, u256> predicates;
-    vector<bytes> outputs;
+    uint64_t cksum = 0;
+    unordered_set<uint64_t> uniqExceptions;
+    Findings findings;
+    set<pair<u256, u256>> compared;
+    lastComparisons.clear();
+    set<bytes> harvested;
+    lastValues.clear();
+    lastTaint.clear();
+    TaintTracker taint;
+    /* Encoded constructor then functions, only traced when tracking taint */
+    auto traces = traceTaint ? ca.traceEncoding(data) : vector<vector<int>>();
+    /* Instruction last hooked at each call depth, its result is on top at the next one */
+    vector<Instruction> previous;
+    /* Operand of the SHA3 or CALLDATALOAD last hooked at each call depth */
+    vector<u256> sources;
+    /* Zero padded input of a call reading past msize */
+    bytes callData;
+    auto harvest = [&](u256 const& value) {
+      if (!value || harvested.size() >= CMPLOG_MAX) return;
+      auto compact = toCompactBigEndian(value);
+      if (harvested.insert(compact).second) lastValues.push_back(compact);
+    };
+    auto harvestWords = [&](bytesConstRef data) {
+      for (size_t offset = 0; offset + 32 <= data.size() && offset < 128; offset += 32) {
+        harvest(fromBigEndian<u256>(data.cropped(offset, 32)));
+      }
+    };
+    tracebits.clear();
+    predicates.clear();
     size_t savepoint = program->savepoint();
     OnOpFunc onOp = [&](u64, u64 pc, Instruction inst, bigint, bigint, bigint, VMFace const* _vm, ExtVMFace const* ext) {
       auto vm = dynamic_cast<LegacyVM const*>(_vm);
+      if (traceTaint) taint.step(pc, inst, vm, ext);
+      auto last = Instruction::STOP;
+      if (harvestValues || logComparisons) {
+        if (previous.size() <= ext->depth) {
+          previous.resize(ext->depth + 1, Instruction::STOP);
+          sources.resize(ext->depth + 1);
+        }
+        last = previous[ext->depth];
+        previous[ext->depth] = inst;
+        /* Hashes and calldata words with what they came from: the first hashed word or the offset */
+        auto derived = last == Instruction::SHA3 || last == Instruction::CALLDATALOAD;
+        if (logComparisons && derived && vm->stackSize() && compared.size() < CMPLOG_MAX) {
+          auto const& value = vm->stackTop(0);
+          auto const& source = sources[ext->depth];
+          if (compared.insert(make_pair(value, source)).second) lastComparisons.push_back(Comparison{last, value, source});
+        }
+        if (inst == Instruction::CALLDATALOAD && vm->stackSize()) sources[ext->depth] = vm->stackTop(0);
+        if (inst == Instruction::SHA3 && vm->stackSize() >= 2) {
+          /* Read past msize as zeros */
+          h256 word;
+          auto input = vm->memoryRef(vm->stackTop(0), min<u256>(vm->stackTop(1), 32));
+          input.copyTo(word.ref());
+          sources[ext->depth] = u256(word);
+        }
+      }
+      if (harvestValues) {
+        switch (last) {
+          case Instruction::SLOAD:
+          case Instruction::SHA3:
+          case Instruction::BALANCE:
+          case Instruction::TIMESTAMP:
+          case Instruction::NUMBER: {
+            if (vm->stackSize()) harvest(vm->stackTop(0));
+            break;
+          }
+          case Instruction::CALL:
+          case Instruction::CALLCODE:
+          case Instruction::DELEGATECALL:
+          case Instruction::STATICCALL: {
+            harvestWords(bytesConstRef(&vm->returnData()));
+            break;
+          }
+          default: { break; }
+        }
+        /* Mapping keys are hashed with their slot */
+        if (inst == Instruction::SHA3 && vm->stackSize() >= 2) {
+          harvestWords(vm->memoryRef(vm->stackTop(0), vm->stackTop(1)));
+        }
+      }
       /* Oracle analyze data */
       switch (inst) {
         case Instruction::CALL:
         case Instruction::CALLCODE:
         case Instruction::DELEGATECALL:
         case Instruction::STATICCALL: {
-          vector<u256>::size_type stackSize = vm->stack().size();
-          u256 wei = (inst == Instruction::CALL || inst == Instruction::CALLCODE) ? vm->stack()[stackSize - 3] : 0;
-          auto sizeOffset = (inst == Instruction::CALL || inst == Instruction::CALLCODE) ? (stackSize - 4) : (stackSize - 3);
-          auto inOff = (uint64_t) vm->stack()[sizeOffset];
-          auto inSize = (uint64_t) vm->stack()[sizeOffset - 1];
-          auto first = vm->memory().begin();
-          OpcodePayload payload;
-          payload.caller = ext->myAddress;
-          payload.callee = Address((u160)vm->stack()[stackSize - 2]);
-          payload.pc = pc;
-          payload.gas = vm->stack()[stackSize - 1];
-          payload.wei = wei;
-          payload.inst = inst;
-          payload.data = bytes(first + inOff, first + inOff + inSize);
-          oracleFactory->save(OpcodeContext(ext->depth + 1, payload));
+          auto withValue = inst == Instruction::CALL || inst == Instruction::CALLCODE;
+          u256 wei = withValue ? vm->stackTop(2) : 0;
+          auto inOff = withValue ? 3 : 2;
+          OracleEvent event;
+          event.level = ext->depth + 1;
+          event.caller = ext->myAddress;
+          event.callee = Address((u160)vm->stackTop(1));
+          event.gas = vm->stackTop(0);
+          event.wei = wei;
+          event.inst = inst;
+          auto const& inSize = vm->stackTop(inOff + 1);
+          event.data = vm->memoryRef(vm->stackTop(inOff), inSize);
+          /* Memory past msize reads as zeros, as the callee will see it */
+          if (event.data.size() < inSize && inSize <= MEMORY_LIMIT) {
+            callData.assign((size_t) inSize, 0);
+            event.data.copyTo(bytesRef(&callData));
+            event.data = bytesConstRef(&callData);
+          }
+          oracleFactory->save(event);
           break;
         }
         default: {
-          OpcodePayload payload;
-          payload.pc = pc;
-          payload.inst = inst;
+          OracleEvent event;
+          event.level = ext->depth + 1;
+          event.inst = inst;
           if (
               inst == Instruction::SUICIDE ||
               inst == Instruction::NUMBER ||
@@ -59,20 +170,19 @@ namespace fuzzer {
               inst == Instruction::ADD ||
               inst == Instruction::SUB
               ) {
-            vector<u256>::size_type stackSize = vm->stack().size();
             if (inst == Instruction::ADD || inst == Instruction::SUB) {
-              auto left = vm->stack()[stackSize - 1];
-              auto right = vm->stack()[stackSize - 2];
+              auto const& left = vm->stackTop(0);
+              auto const& right = vm->stackTop(1);
               if (inst == Instruction::ADD) {
                 auto total256 = left + right;
                 auto total512 = (u512) left + (u512) right;
-                payload.isOverflow = total512 != total256;
+                event.isOverflow = total512 != total256;
               }
               if (inst == Instruction::SUB) {
-                payload.isUnderflow = left < right;
+                event.isUnderflow = left < right;
               }
             }
-            oracleFactory->save(OpcodeContext(ext->depth + 1, payload));
+            oracleFactory->save(event);
           }
           break;
         }
@@ -84,95 +194,145 @@ namespace fuzzer {
         case Instruction::LT:
         case Instruction::SLT:
         case Instruction::EQ: {
-          vector<u256>::size_type stackSize = vm->stack().size();
-          if (stackSize >= 2) {
-            u256 left = vm->stack()[stackSize - 1];
-            u256 right = vm->stack()[stackSize - 2];
+          if (vm->stackSize() >= 2) {
+            auto const& left = vm->stackTop(0);
+            auto const& right = vm->stackTop(1);
             /* calculate if command inside a function */
             u256 temp = left > right ? left - right : right - left;
             lastCompValue = temp + 1;
+            if (logComparisons && compared.size() < CMPLOG_MAX && compared.insert(make_pair(left, right)).second) {
+              lastComparisons.push_back(Comparison{inst, left, right});
+            }
           }
           break;
         }
         default: { break; }
       }
-      /* Calculate left and right branches for valid jumpis*/
+      /* Record the branch taken by a valid jumpi and add the reverse branch to predicate */
       auto recordable = recordParam.isDeployment && get<0>(validJumpis).count(pc);
       recordable = recordable || !recordParam.isDeployment && get<1>(validJumpis).count(pc);
       if (inst == Instruction::JUMPCI && recordable) {
-        jumpDest1 = (u64) vm->stack().back();
-        jumpDest2 = pc + 1;
-      }
-      /* Calculate actual jumpdest and add reverse branch to predicate */
-      recordable = recordParam.isDeployment && get<0>(validJumpis).count(recordParam.lastpc);
-      recordable = recordable || !recordParam.isDeployment && get<1>(validJumpis).count(recordParam.lastpc);
-      if (prevInst == Instruction::JUMPCI && recordable) {
-        auto branchId = to_string(recordParam.lastpc) + ":" + to_string(pc);
-        tracebits.insert(branchId);
+        u64 jumpDest1 = (u64) vm->stackTop(0);
+        u64 jumpDest2 = pc + 1;
+        u64 jumpDest = vm->stackTop(1) ? jumpDest1 : jumpDest2;
+        auto branchId = toBranchId(pc, jumpDest);
+        if (tracebits.record(branchId)) cksum = hashBranch(cksum, branchId);
         /* Calculate branch distance */
-        u64 jumpDest = pc == jumpDest1 ? jumpDest2 : jumpDest1;
-        branchId = to_string(recordParam.lastpc) + ":" + to_string(jumpDest);
-        predicates[branchId] = lastCompValue;
+        jumpDest = jumpDest == jumpDest1 ? jumpDest2 : jumpDest1;
+        predicates.record(toBranchId(pc, jumpDest), lastCompValue);
       }
-      prevInst = inst;
-      recordParam.lastpc = pc;
     };
+    /* Only subscribed instructions reach the hook */
+    HookedInstructionsGuard hooked(harvestValues || traceTaint || logComparisons ? bitset<256>().set() : hookedInstructions);
     /* Decode and call functions */
     ca.updateTestData(data);
     vector<bytes> funcs = ca.encodeFunctions();
-    program->deploy(addr, code);
-    program->setBalance(addr, DEFAULT_BALANCE);
-    program->updateEnv(ca.decodeAccounts(), ca.decodeBlock());
-    oracleFactory->initialize();
+    vector<FuncDef> fds;
+    copy_if(ca.fds.begin(), ca.fds.end(), back_inserter(fds), [](const FuncDef &fd) { return fd.name != ""; });
+    Sequence calls = sequence;
+    if (!funcs.size()) calls.clear();
+    if (!sequence.size()) {
+      for (uint32_t funcIdx = 0; funcIdx < funcs.size(); funcIdx ++) calls.push_back(funcIdx);
+    }
+    auto sender = ca.getSender();
+    /* Key of every prefix: the deployment, then one more call each */
+    vector<h256> keys = { constructorKey() };
+    for (auto funcIdx : calls) keys.push_back(SnapshotTrie::childKey(keys.back(), funcs[funcIdx % funcs.size()]));
+    if (!baseSnapshot) baseSnapshot = make_shared<ProgramSnapshot>(program->snapshot());
+    auto saveSnapshot = [&](h256 const& key) {
+      if (!snapshots->wanted(key)) return;
+      snapshots->insert(key, [&]() {
+        return PrefixRecord{
+          program->snapshot(),
+          tracebits.hits(),
+          predicates.hitsWithValues(),
+          cksum,
+          uniqExceptions,
+          findings,
+          lastCompValue
+        };
+      });
+    };
+    /* Resume from the longest cached prefix */
+    size_t numResumed = keys.size();
+    PrefixRecord *record = nullptr;
+    /* Records keep no operands, values nor taint, logging runs replay every call */
+    if (logComparisons || harvestValues || traceTaint) numResumed = 0;
+    while (numResumed > 0 && !record) record = snapshots->find(keys[-- numResumed]);
     /* Record all JUMPI in constructor */
     recordParam.isDeployment = true;
-    auto sender = ca.getSender();
-    OpcodePayload payload;
-    payload.inst = Instruction::CALL;
-    payload.data = ca.encodeConstructor();
-    payload.wei = ca.isPayable("") ? program->getBalance(sender) / 2 : 0;
-    payload.caller = sender;
-    payload.callee = addr;
-    oracleFactory->save(OpcodeContext(0, payload));
-    auto res = program->invoke(addr, CONTRACT_CONSTRUCTOR, ca.encodeConstructor(), ca.isPayable(""), onOp);
-    if (res.excepted != TransactionException::None) {
-      auto exceptionId = to_string(recordParam.lastpc);
-      uniqExceptions.insert(exceptionId) ;
-      /* Save Call Log */
-      OpcodePayload payload;
-      payload.inst = Instruction::INVALID;
-      oracleFactory->save(OpcodeContext(0, payload));
+    if (record) {
+      /* Replay what the prefix reported to the hook */
+      program->restore(record->snapshot);
+      for (auto branchId : record->tracebits) tracebits.record(branchId);
+      for (auto &predicate : record->predicates) predicates.record(predicate.first, predicate.second);
+      oracleFactory->merge(record->findings);
+      cksum = record->cksum;
+      uniqExceptions = record->uniqExceptions;
+      findings = record->findings;
+      lastCompValue = record->lastCompValue;
+    } else {
+      program->deploy(addr, code);
+      program->setBalance(addr, DEFAULT_BALANCE);
+      program->updateEnv(ca.decodeAccounts(), ca.decodeBlock());
+      oracleFactory->initialize();
+      auto constructorData = ca.encodeConstructor();
+      OracleEvent event;
+      event.inst = Instruction::CALL;
+      event.data = bytesConstRef(&constructorData);
+      event.wei = ca.isPayable("") ? program->getBalance(sender) / 2 : 0;
+      event.caller = sender;
+      event.callee = addr;
+      oracleFactory->save(event);
+      if (traceTaint) taint.begin(traces[0]);
+      /* Exceptions are told apart by the pc they happened at, not by the last hooked one */
+      LegacyVM::faultPC = 0;
+      auto res = program->invoke(addr, CONTRACT_CONSTRUCTOR, constructorData, ca.isPayable(""), onOp);
+      if (res.excepted != TransactionException::None) {
+        uniqExceptions.insert(LegacyVM::faultPC);
+        /* Save Call Log */
+        OracleEvent event;
+        event.inst = Instruction::INVALID;
+        oracleFactory->save(event);
+      }
+      oracleFactory->finalize();
+      findings |= oracleFactory->current();
+      saveSnapshot(keys[0]);
     }
-    oracleFactory->finalize();
-    for (uint32_t funcIdx = 0; funcIdx < funcs.size(); funcIdx ++ ) {
+    for (auto callIdx = numResumed + 1; callIdx < keys.size(); callIdx ++) {
       /* Update payload */
+      auto funcIdx = calls[callIdx - 1] % funcs.size();
       auto func = funcs[funcIdx];
-      auto fd = ca.fds[funcIdx];
+      auto fd = fds[funcIdx];
       /* Ignore JUMPI until program reaches inside function */
       recordParam.isDeployment = false;
-      OpcodePayload payload;
-      payload.data = func;
-      payload.inst = Instruction::CALL;
-      payload.wei = ca.isPayable(fd.name) ? program->getBalance(sender) / 2 : 0;
-      payload.caller = sender;
-      payload.callee = addr;
-      oracleFactory->save(OpcodeContext(0, payload));
-      res = program->invoke(addr, CONTRACT_FUNCTION, func, ca.isPayable(fd.name), onOp);
-      outputs.push_back(res.output);
+      oracleFactory->initialize();
+      OracleEvent event;
+      event.data = bytesConstRef(&func);
+      event.inst = Instruction::CALL;
+      event.wei = ca.isPayable(fd.name) ? program->getBalance(sender) / 2 : 0;
+      event.caller = sender;
+      event.callee = addr;
+      oracleFactory->save(event);
+      if (traceTaint) taint.begin(traces[funcIdx + 1]);
+      LegacyVM::faultPC = 0;
+      auto res = program->invoke(addr, CONTRACT_FUNCTION, func, ca.isPayable(fd.name), onOp);
       if (res.excepted != TransactionException::None) {
-        auto exceptionId = to_string(recordParam.lastpc);
-        uniqExceptions.insert(exceptionId);
+        uniqExceptions.insert(LegacyVM::faultPC);
         /* Save Call Log */
-        OpcodePayload payload;
-        payload.inst = Instruction::INVALID;
-        oracleFactory->save(OpcodeContext(0, payload));
+        OracleEvent event;
+        event.inst = Instruction::INVALID;
+        oracleFactory->save(event);
       }
       oracleFactory->finalize();
+      findings |= oracleFactory->current();
+      saveSnapshot(keys[callIdx]);
     }
     /* Reset data before running new contract */
     program->rollback(savepoint);
-    string cksum = "";
-    for (auto t : tracebits) cksum = cksum + t;
-    return TargetContainerResult(tracebits, predicates, uniqExceptions, cksum);
+    if (record) program->restore(*baseSnapshot);
+    lastFindings = findings;
+    if (traceTaint) lastTaint = taint.jumpis();
+    return TargetContainerResult(tracebits.hits(), predicates.hitsWithValues(), uniqExceptions, cksum);
   }
 }
@@ -1,11 +1,17 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <set>
+#include <bitset>
+#include <memory>
 #include <liboracle/OracleFactory.h>
 #include "Common.h"
 #include "TargetProgram.h"
 #include "ContractABI.h"
 #include "TargetContainerResult.h"
+#include "SnapshotTrie.h"
+#include "Taint.h"
+#include "FuzzItem.h"
 #include "Util.h"
 
 using namespace dev;
@@ -14,16 +20,52 @@ using namespace std;
 
 namespace fuzzer {
   struct RecordParam {
-    u64 lastpc = 0;
     bool isDeployment = false;
   };
+  static size_t SNAPSHOT_BUDGET = 64 << 20;
+  /*
+   * Operands of a comparison as they were on the stack, left on top. SHA3
+   * and CALLDATALOAD log their result on the left, the first hashed word or
+   * the offset on the right
+   */
+  struct Comparison {
+    Instruction inst;
+    u256 left;
+    u256 right;
+  };
   class TargetExecutive {
       TargetProgram *program;
       OracleFactory *oracleFactory;
       ContractABI ca;
       bytes code;
+      /* Reused across executions */
+      CoverageMap tracebits;
+      CoverageMap predicates;
+      /* State before deployment, restored after executions resumed from a snapshot */
+      shared_ptr<ProgramSnapshot> baseSnapshot;
+      h256 constructorKey();
     public:
       Address addr;
+      /* Snapshots of call prefixes, a zero budget disables them */
+      shared_ptr<SnapshotTrie> snapshots = make_shared<SnapshotTrie>(SNAPSHOT_BUDGET);
+      /* Instructions passed to the exec hook, all others run unhooked */
+      bitset<256> hookedInstructions = defaultHookedInstructions();
+      static bitset<256> defaultHookedInstructions();
+      /* Oracles found by the calls of the last execution */
+      Findings lastFindings;
+      /* Log distinct comparison operands, hashes and calldata words, up to CMPLOG_MAX, into lastComparisons. Hooks every instruction */
+      bool logComparisons = false;
+      vector<Comparison> lastComparisons;
+      /*
+       * Collect distinct values produced at runtime, up to CMPLOG_MAX, into
+       * lastValues: storage reads, hashes and the words they hash, block
+       * values, balances and words returned by calls. Hooks every instruction
+       */
+      bool harvestValues = false;
+      vector<bytes> lastValues;
+      /* Track test data bytes into lastTaint: labels of every JUMPI condition by pc. Hooks every instruction */
+      bool traceTaint = false;
+      unordered_map<u64, Taint> lastTaint;
       TargetExecutive(OracleFactory *oracleFactory, TargetProgram *program, Address addr, ContractABI ca, bytes code) {
         this->code = code;
         this->ca = ca;
@@ -31,7 +73,7 @@ namespace fuzzer {
         this->program = program;
         this->oracleFactory = oracleFactory;
       }
-      TargetContainerResult exec(bytes data, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>> &validJumpis);
+      TargetContainerResult exec(bytes data, const tuple<unordered_set<uint64_t>, unordered_set<uint64_t>> &validJumpis, const Sequence &sequence = Sequence());
       void deploy(bytes data, OnOpFunc onOp);
   };
 }
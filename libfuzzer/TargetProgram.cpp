@@ -1,3 +1,4 @@
+#include <mutex>
 #include "TargetProgram.h"
 #include "Util.h"
 
@@ -5,7 +6,7 @@ using namespace dev;
 using namespace eth;
 
 namespace fuzzer {
-  TargetProgram::TargetProgram(): state(State(0)) {
+  TargetProgram::TargetProgram(StateBackend backend): state(backend == FLAT_STATE ? State(0, State::Flat) : State(0)) {
     Network networkName = Network::MainNetworkTest;
     LastBlockHashes lastBlockHashes;
     BlockHeader blockHeader;
@@ -14,8 +15,12 @@ namespace fuzzer {
     gas = MAX_GAS;
     timestamp = 0;
     blockNumber = 2675000;
-    Ethash::init();
-    NoProof::init();
+    /* Seal engines are registered globally, do it once for all threads */
+    static once_flag sealEnginesRegistered;
+    call_once(sealEnginesRegistered, []() {
+      Ethash::init();
+      NoProof::init();
+    });
     se = ChainParams(genesisInfo(networkName)).createSealEngine();
     // add value
     blockHeader.setGasLimit(maxGasLimit);
@@ -97,6 +102,18 @@ namespace fuzzer {
   size_t TargetProgram::savepoint() {
     return state.savepoint();
   }
+
+  ProgramSnapshot TargetProgram::snapshot() {
+    return ProgramSnapshot{state, sender, timestamp, blockNumber};
+  }
+
+  /* Copies accounts only, the changelog keeps counting from the current savepoint */
+  void TargetProgram::restore(const ProgramSnapshot &snapshot) {
+    state = snapshot.state;
+    sender = snapshot.sender;
+    timestamp = snapshot.timestamp;
+    blockNumber = snapshot.blockNumber;
+  }
   
   TargetProgram::~TargetProgram() {
     delete envInfo;
@@ -10,6 +10,15 @@ using namespace std;
 
 namespace fuzzer {
   enum ContractCall { CONTRACT_CONSTRUCTOR, CONTRACT_FUNCTION };
+  /* TRIE: State over OverlayDB as in a node, FLAT: cache-only State without trie */
+  enum StateBackend { TRIE_STATE, FLAT_STATE };
+  /* State and environment to resume execution from */
+  struct ProgramSnapshot {
+    State state;
+    u160 sender;
+    int64_t timestamp;
+    int64_t blockNumber;
+  };
   class TargetProgram {
     private:
       State state;
@@ -21,7 +30,7 @@ namespace fuzzer {
       SealEngineFace *se;
       ExecutionResult invoke(Address addr, bytes data, bool payable, OnOpFunc onOp);
     public:
-      TargetProgram();
+      TargetProgram(StateBackend backend = FLAT_STATE);
       ~TargetProgram();
       u256 getBalance(Address addr);
       bytes getCode(Address addr);
@@ -32,6 +41,8 @@ namespace fuzzer {
       unordered_map<Address, u256> addresses();
       size_t savepoint();
       void rollback(size_t savepoint);
+      ProgramSnapshot snapshot();
+      void restore(const ProgramSnapshot &snapshot);
       ExecutionResult invoke(Address addr, ContractCall type, bytes data, bool payable, OnOpFunc onOp);
   };
 }
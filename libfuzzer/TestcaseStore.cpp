@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstring>
+#include "TestcaseStore.h"
+
+using namespace dev;
+using namespace std;
+using namespace fuzzer;
+
+FuzzItem Testcase::toItem() const {
+  FuzzItem item(data.toBytes(), sequence);
+  item.res = res;
+  item.depth = depth;
+  return item;
+}
+
+void TestcaseStore::place(shared_ptr<Testcase> const& testcase, bytesConstRef data) {
+  auto size = data.size();
+  if (!slab || used + size > slab->size()) {
+    /* Larger testcases get a slab of their own */
+    slab = make_shared<bytes>(max(slabSize, size));
+    /* Forget the slabs whose testcases were all replaced */
+    slabs.remove_if([](Slab const& it) { return it.data.expired(); });
+    slabs.push_back(Slab{slab, {}, false});
+    startedSlabs ++;
+    used = 0;
+  }
+  auto ptr = slab->data() + used;
+  if (size) memcpy(ptr, data.data(), size);
+  used += size;
+  testcase->data = bytesConstRef(ptr, size);
+  testcase->slab = slab;
+  slabs.back().testcases.push_back(testcase);
+}
+
+TestcaseRef TestcaseStore::add(const FuzzItem &item) {
+  auto testcase = make_shared<Testcase>();
+  testcase->sequence = item.sequence;
+  testcase->res = item.res;
+  testcase->depth = item.depth;
+  testcase->id = nextId ++;
+  place(testcase, bytesConstRef(&item.data));
+  return testcase;
+}
+
+size_t TestcaseStore::memory() {
+  size_t ret = 0;
+  for (auto it = slabs.begin(); it != slabs.end();) {
+    auto alive = it->data.lock();
+    if (!alive) {
+      it = slabs.erase(it);
+      continue;
+    }
+    ret += alive->size();
+    it ++;
+  }
+  return ret;
+}
+
+unordered_map<const Testcase *, TestcaseRef> TestcaseStore::compact() {
+  unordered_map<const Testcase *, TestcaseRef> moved;
+  auto current = slab;
+  /* Held until done, so starting a slab for the copies forgets none of them */
+  slabs.remove_if([](Slab const& it) { return it.data.expired(); });
+  vector<shared_ptr<bytes>> held;
+  for (auto const& it : slabs) held.push_back(it.data.lock());
+  /* Slabs started by the copies are appended, and are not looked at */
+  auto it = slabs.begin();
+  for (auto const& data : held) {
+    /* Testcases still referenced, dropping the others */
+    vector<TestcaseRef> alive;
+    size_t liveBytes = 0;
+    auto &testcases = it->testcases;
+    testcases.erase(remove_if(testcases.begin(), testcases.end(), [&](weak_ptr<const Testcase> const& testcase) {
+      auto locked = testcase.lock();
+      if (!locked) return true;
+      liveBytes += locked->data.size();
+      alive.push_back(locked);
+      return false;
+    }), testcases.end());
+    if (data != current && !it->evacuated && liveBytes * 4 < data->size()) {
+      for (auto const& old : alive) {
+        auto copy = make_shared<Testcase>(*old);
+        place(copy, old->data);
+        moved[old.get()] = copy;
+      }
+      it->evacuated = true;
+    }
+    it ++;
+  }
+  startedSlabs = 0;
+  compactAt = max(COMPACT_MIN_SLABS, slabs.size());
+  return moved;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "FuzzItem.h"
+
+using namespace dev;
+using namespace std;
+
+namespace fuzzer {
+  static size_t SLAB_SIZE = 1 << 16;
+  /* Slabs started before sparse ones are looked for, grows with the store */
+  static size_t COMPACT_MIN_SLABS = 16;
+  /* Immutable testcase, its bytes live in a slab of the store */
+  struct Testcase {
+    bytesConstRef data;
+    Sequence sequence;
+    TargetContainerResult res;
+    uint64_t depth = 0;
+    /* Kept by the copies made when compacting, a moved testcase is still the same leader */
+    uint64_t id = 0;
+    /* Keeps the slab alive as long as the testcase is referenced */
+    shared_ptr<bytes> slab;
+    FuzzItem toItem() const;
+  };
+  using TestcaseRef = shared_ptr<const Testcase>;
+  /*
+   * Arena of leader testcases. Bytes are appended to fixed size slabs and
+   * never move, testcases are shared through refcounted handles so that a
+   * testcase leading many branches is stored once. A slab is freed once no
+   * handle refers to it, so a few long lived leaders can pin mostly empty
+   * slabs until compact() copies them out. Not thread safe, the fuzzer
+   * guards it with the frontier.
+   */
+  class TestcaseStore {
+    struct Slab {
+      weak_ptr<bytes> data;
+      vector<weak_ptr<const Testcase>> testcases;
+      /* Its testcases were copied out, the old handles are all that keep it */
+      bool evacuated;
+    };
+    size_t slabSize;
+    shared_ptr<bytes> slab;
+    size_t used = 0;
+    list<Slab> slabs;
+    uint64_t nextId = 0;
+    size_t startedSlabs = 0;
+    size_t compactAt = COMPACT_MIN_SLABS;
+    void place(shared_ptr<Testcase> const& testcase, bytesConstRef data);
+    public:
+      TestcaseStore(size_t slabSize = SLAB_SIZE): slabSize(slabSize) {}
+      TestcaseRef add(const FuzzItem &item);
+      /* Bytes of the slabs still referenced */
+      size_t memory();
+      /* Slabs tracked, freed ones are forgotten when the next slab starts */
+      size_t numSlabs() const { return slabs.size(); }
+      /* Enough slabs were started since the last compaction to look for sparse ones */
+      bool wantsCompaction() const { return startedSlabs >= compactAt; }
+      /*
+       * Copy the testcases still referenced from slabs less than a quarter
+       * full into new slabs. Returns the copy of every moved testcase, a
+       * sparse slab is freed once its handles are swapped for the copies
+       */
+      unordered_map<const Testcase *, TestcaseRef> compact();
+  };
+}
@@ -1,9 +1,12 @@
+#include <random>
 #include "Util.h"
 #include "Logger.h"
 
 namespace fuzzer {
   u32 UR(u32 limit) {
-    return random() % limit;
+    /* random() serializes on a global lock, keep one generator per thread */
+    static thread_local mt19937 generator(random());
+    return generator() % limit;
   }
 
   int effAPos(int p) {
@@ -142,7 +145,7 @@ namespace fuzzer {
     return (UR(maxFactor) + 1) * 32;
   }
 
-  void locateDiffs(byte* ptr1, byte* ptr2, u32 len, s32* first, s32* last) {
+  void locateDiffs(const byte* ptr1, const byte* ptr2, u32 len, s32* first, s32* last) {
     s32 f_loc = -1;
     s32 l_loc = -1;
     u32 pos;
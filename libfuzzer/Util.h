@@ -54,6 +54,7 @@ namespace fuzzer {
   static OnOpFunc EMPTY_ONOP = [](u64, u64, Instruction, bigint, bigint, bigint, VMFace const*, ExtVMFace const*) {};
 
   static u32 SPLICE_CYCLES = 15;
+  static u32 MAX_SEQUENCE_LENGTH = 16;
   static u32 MAX_DET_EXTRAS = 200;
   static int STAGE_FLIP1 = 0;
   static int STAGE_FLIP2 = 1;
@@ -71,9 +72,21 @@ namespace fuzzer {
   static int STAGE_EXTRAS_AO = 14;
   static int STAGE_HAVOC = 15;
   static int STAGE_RANDOM = 16;
+  static int STAGE_SEQUENCE = 17;
+  static int STAGE_TRIM = 18;
+  static int STAGE_ABI = 19;
+  static int STAGE_I2S = 20;
+  static int STAGE_SEARCH = 21;
   static int HAVOC_STACK_POW2 = 7;
   static int HAVOC_MIN = 16;
-  static int EFF_MAP_SCALE2 = 4; // 32 bytes block
+  static size_t BATCH_SIZE = 64;
+  static size_t BATCH_DEPTH = 2;
+  static size_t CMPLOG_MAX = 256;
+  /* Memory regions past it would run out of gas, hooks do not read them */
+  static u64 MEMORY_LIMIT = 1 << 20;
+  static size_t RUNTIME_DICT_MAX = 128;
+  static u32 SEARCH_MAX = 128;
+  static int EFF_MAP_SCALE2 = 0; // byte granularity, aligned to ABI values by Mutation
   static int ARITH_MAX = 35;
   static int EFF_MAX_PERC = 90;
   static s8 INTERESTING_8[] = { -128, -1, 0, 1, 16, 32, 64, 100, 127};
@@ -98,12 +111,15 @@ namespace fuzzer {
   /* Swap 4 bytes */
   u32 swap32(u32 x);
   /* Locate differents */
-  void locateDiffs(byte* ptr1, byte* ptr2, u32 len, s32* first, s32* last);
+  void locateDiffs(const byte* ptr1, const byte* ptr2, u32 len, s32* first, s32* last);
   string formatDuration(int duration);
   string padStr(string str, int len);
   /* Data struct */
   struct ExtraData {
     bytes data;
+    /* Candidates built from it by the dictionary stage, and how many were kept */
+    uint64_t uses = 0;
+    uint64_t finds = 0;
   };
   vector<string> splitString(string str, char separator);
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <iostream>
+#include <bitset>
 #include <libdevcore/CommonIO.h>
 #include <libevm/LegacyVM.h>
 
@@ -17,23 +18,25 @@ const uint8_t FREEZING = 6;
 const uint8_t OVERFLOW = 7;
 const uint8_t UNDERFLOW = 8;
 
-struct OpcodePayload {
+const uint8_t TOTAL_ORACLES = 9;
+
+/* One bit per oracle */
+using Findings = bitset<TOTAL_ORACLES>;
+
+/*
+ * Event of the running transaction, built on the stack by the hook and
+ * consumed right away. Data points to the memory of the VM or to the call
+ * data, it is only valid while the event is saved.
+ */
+struct OracleEvent {
+  /* Depth of the call, 0 for the transaction itself */
+  uint16_t level = 0;
+  Instruction inst = Instruction::STOP;
   u256 wei = 0;
   u256 gas = 0;
-  u256 pc = 0;
-  Instruction inst;
-  bytes data;
+  bytesConstRef data;
   Address caller;
   Address callee;
   bool isOverflow = false;
   bool isUnderflow = false;
 };
-
-struct OpcodeContext {
-  u256 level;
-  OpcodePayload payload;
-  OpcodeContext(u256 _level, OpcodePayload _payload): level(_level), payload(_payload) {}
-};
-
-using SingleFunction = vector<OpcodeContext>;
-using MultipleFunction = vector<SingleFunction>;
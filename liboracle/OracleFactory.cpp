@@ -1,123 +1,87 @@
+#include <algorithm>
 #include "OracleFactory.h"
 
 using namespace dev;
 using namespace eth;
 using namespace std;
 
-void OracleFactory::initialize() {
-  function.clear();
+namespace {
+  /* Call data of the attacker agent when it calls back */
+  const byte LOOP_SELECTOR[] = {0x00, 0x00, 0x00, 0xff};
+
+  bool sameBytes(bytesConstRef a, bytesConstRef b) {
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin());
+  }
 }
 
-void OracleFactory::finalize() {
-  functions.push_back(function);
-  function.clear();
+void OracleFactory::initialize() {
+  /* Keeps the capacity of the root data */
+  state.hasRoot = false;
+  state.rootData.clear();
+  state.rootCaller = Address();
+  state.hasTransfer = state.hasTimestamp = state.hasNumber = false;
+  state.hasLoop = state.hasDelegate = state.hasDirectTransfer = false;
+  state.nestedException = state.rootException = false;
+  findings.reset();
 }
 
-void OracleFactory::save(OpcodeContext ctx) {
-  function.push_back(ctx);
+void OracleFactory::found(uint8_t oracle) {
+  findings.set(oracle);
+  vulnerabilities[oracle] = true;
 }
 
-vector<bool> OracleFactory::analyze() {
-  uint8_t total = 9;
-  while (vulnerabilities.size() < total) {
-    vulnerabilities.push_back(false);
+void OracleFactory::save(OracleEvent const& event) {
+  auto inst = event.inst;
+  auto level = event.level;
+  /* The transaction itself is the first event */
+  if (!state.hasRoot) {
+    state.hasRoot = true;
+    state.rootData.assign(event.data.begin(), event.data.end());
+    state.rootCaller = event.caller;
+  }
+  if (event.wei > 0) state.hasTransfer = true;
+  /* GASLESS_SEND: a plain send from the contract with the stipend or no gas */
+  if (level == 1 && inst == Instruction::CALL && event.data.empty() && (event.gas == 2300 || event.gas == 0)) {
+    found(GASLESS_SEND);
+  }
+  /* EXCEPTION_DISORDER: decided at the end, the root exception comes last */
+  if (inst == Instruction::INVALID) {
+    if (level) state.nestedException = true;
+    else state.rootException = true;
   }
-  for (auto function : functions) {
-    for (uint8_t i = 0; i < total; i ++) {
-      if (!vulnerabilities[i]) {
-        switch (i) {
-          case GASLESS_SEND: {
-            for (auto ctx: function) {
-              auto level = ctx.level;
-              auto inst = ctx.payload.inst;
-              auto gas = ctx.payload.gas;
-              auto data = ctx.payload.data;
-              vulnerabilities[i] = vulnerabilities[i] || (level == 1 && inst == Instruction::CALL && !data.size() && (gas == 2300 || gas == 0));
-            }
-            break;
-          }
-          case EXCEPTION_DISORDER: {
-            auto rootCallResponse = function[function.size() - 1];
-            bool rootException = rootCallResponse.payload.inst == Instruction::INVALID && !rootCallResponse.level;
-            for (auto ctx : function) {
-              vulnerabilities[i] = vulnerabilities[i] || (!rootException && ctx.payload.inst == Instruction::INVALID && ctx.level);
-            }
-            break;
-          }
-          case TIME_DEPENDENCY: {
-            auto has_transfer = false;
-            auto has_timestamp = false;
-            for (auto ctx : function) {
-              has_transfer = has_transfer || ctx.payload.wei > 0;
-              has_timestamp = has_timestamp || ctx.payload.inst == Instruction::TIMESTAMP;
-            }
-            vulnerabilities[i] = has_transfer && has_timestamp;
-            break;
-          }
-          case NUMBER_DEPENDENCY: {
-            auto has_transfer = false;
-            auto has_number = false;
-            for (auto ctx : function) {
-              has_transfer = has_transfer || ctx.payload.wei > 0;
-              has_number = has_number || ctx.payload.inst == Instruction::NUMBER;
-            }
-            vulnerabilities[i] = has_transfer && has_number;
-            break;
-          }
-          case DELEGATE_CALL: {
-            auto rootCall = function[0];
-            auto data = rootCall.payload.data;
-            auto caller = rootCall.payload.caller;
-            for (auto ctx : function) {
-              if (ctx.payload.inst == Instruction::DELEGATECALL) {
-                vulnerabilities[i] = vulnerabilities[i]
-                    || data == ctx.payload.data
-                    || caller == ctx.payload.callee
-                    || toHex(data).find(toHex(ctx.payload.callee)) != string::npos;
-              }
-            }
-            break;
-          }
-          case REENTRANCY: {
-            auto has_loop = false;
-            auto has_transfer = false;
-            for (auto ctx : function) {
-              has_loop = has_loop || (ctx.level >= 4 &&  toHex(ctx.payload.data) == "000000ff");
-              has_transfer = has_transfer || ctx.payload.wei > 0;
-            }
-            vulnerabilities[i] = has_loop && has_transfer;
-            break;
-          }
-          case FREEZING: {
-            auto has_delegate = false;
-            auto has_transfer = false;
-            for (auto ctx: function) {
-              has_delegate = has_delegate || ctx.payload.inst == Instruction::DELEGATECALL;
-              has_transfer = has_transfer || (ctx.level == 1 && (
-                   ctx.payload.inst == Instruction::CALL
-                || ctx.payload.inst == Instruction::CALLCODE
-                || ctx.payload.inst == Instruction::SUICIDE
-              ));
-            }
-            vulnerabilities[i] = has_delegate && !has_transfer;
-            break;
-          }
-          case UNDERFLOW: {
-            for (auto ctx: function) {
-              vulnerabilities[i] = vulnerabilities[i] || ctx.payload.isUnderflow;
-            }
-            break;
-          }
-          case OVERFLOW: {
-            for (auto ctx: function) {
-              vulnerabilities[i] = vulnerabilities[i] || ctx.payload.isOverflow;
-            }
-            break;
-          }
-        }
-      }
-    }
+  /* TIME_DEPENDENCY and NUMBER_DEPENDENCY: block fields in a transaction moving ether */
+  if (inst == Instruction::TIMESTAMP) state.hasTimestamp = true;
+  if (inst == Instruction::NUMBER) state.hasNumber = true;
+  if (state.hasTransfer && state.hasTimestamp) found(TIME_DEPENDENCY);
+  if (state.hasTransfer && state.hasNumber) found(NUMBER_DEPENDENCY);
+  /* DELEGATE_CALL: target or data controlled by the caller */
+  if (inst == Instruction::DELEGATECALL) {
+    state.hasDelegate = true;
+    auto const& data = state.rootData;
+    auto callee = event.callee.ref();
+    auto controlled = sameBytes(event.data, bytesConstRef(&data))
+      || state.rootCaller == event.callee
+      || search(data.begin(), data.end(), callee.begin(), callee.end()) != data.end();
+    if (controlled) found(DELEGATE_CALL);
+  }
+  /* REENTRANCY: the attacker agent calls back deep enough, with ether moved */
+  if (level >= 4 && sameBytes(event.data, bytesConstRef(LOOP_SELECTOR, sizeof(LOOP_SELECTOR)))) state.hasLoop = true;
+  if (state.hasLoop && state.hasTransfer) found(REENTRANCY);
+  /* FREEZING: decided at the end, delegates but never sends ether itself */
+  if (level == 1 && (inst == Instruction::CALL || inst == Instruction::CALLCODE || inst == Instruction::SUICIDE)) {
+    state.hasDirectTransfer = true;
+  }
+  if (event.isOverflow) found(OVERFLOW);
+  if (event.isUnderflow) found(UNDERFLOW);
+}
+
+void OracleFactory::finalize() {
+  if (state.nestedException && !state.rootException) found(EXCEPTION_DISORDER);
+  if (state.hasDelegate && !state.hasDirectTransfer) found(FREEZING);
+}
+
+void OracleFactory::merge(Findings const& replayed) {
+  for (uint8_t i = 0; i < TOTAL_ORACLES; i ++) {
+    if (replayed[i]) vulnerabilities[i] = true;
   }
-  functions.clear();
-  return vulnerabilities;
 }
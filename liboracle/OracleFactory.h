@@ -6,13 +6,40 @@ using namespace dev;
 using namespace eth;
 using namespace std;
 
+/*
+ * Online oracles. Every detector is a small state machine over the events of
+ * one transaction: flags set while events stream in, decided either on the
+ * event which completes the pattern or at the end of the transaction. Memory
+ * does not grow with the number of events.
+ */
 class OracleFactory {
-    MultipleFunction functions;
-    SingleFunction function;
+    /* Per transaction state, reset by initialize */
+    struct State {
+      bool hasRoot = false;
+      bytes rootData;
+      Address rootCaller;
+      bool hasTransfer = false;
+      bool hasTimestamp = false;
+      bool hasNumber = false;
+      bool hasLoop = false;
+      bool hasDelegate = false;
+      bool hasDirectTransfer = false;
+      bool nestedException = false;
+      bool rootException = false;
+    };
+    State state;
+    Findings findings;
     vector<bool> vulnerabilities;
+    void found(uint8_t oracle);
   public:
+    OracleFactory(): vulnerabilities(TOTAL_ORACLES, false) {}
     void initialize();
     void finalize();
-    void save(OpcodeContext ctx);
-    vector<bool> analyze();
+    void save(OracleEvent const& event);
+    /* Findings of the transaction since initialize, complete after finalize */
+    Findings const& current() const { return findings; }
+    /* Findings of transactions which were not executed again, e.g. resumed from a snapshot */
+    void merge(Findings const& replayed);
+    /* Every oracle found so far */
+    vector<bool> analyze() const { return vulnerabilities; }
 };
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdlib>
+#include <chrono>
+#include <functional>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <libfuzzer/TargetContainer.h>
+#include <libfuzzer/BytecodeBranch.h>
+
+using namespace fuzzer;
+using namespace std;
+namespace pt = boost::property_tree;
+
+using BenchmarkJumpis = tuple<unordered_set<uint64_t>, unordered_set<uint64_t>>;
+using OnBenchmarkContract = function<void (string name, bytes bin, ContractABI ca, const BenchmarkJumpis &validJumpis)>;
+
+/*
+ * Run cb for every contract compiled by `solc --combined-json abi,bin`
+ * in $BENCHMARK_CONTRACTS (default: contracts/). Every JUMPI counts as a
+ * valid jumpi so that the hook does its full work
+ */
+inline void forEachBenchmarkContract(OnBenchmarkContract cb) {
+  auto folder = getenv("BENCHMARK_CONTRACTS") ? string(getenv("BENCHMARK_CONTRACTS")) : "contracts/";
+  for (auto &file : boost::filesystem::directory_iterator(folder)) {
+    if (file.path().extension() != ".json") continue;
+    pt::ptree root;
+    pt::read_json(file.path().string(), root);
+    for (auto &contract : root.get_child("contracts")) {
+      auto bin = fromHex(contract.second.get<string>("bin"));
+      if (!bin.size()) continue;
+      unordered_set<uint64_t> jumpis;
+      for (auto it : BytecodeBranch::decodeBytecode(bin)) {
+        if (it.second == Instruction::JUMPI) jumpis.insert(it.first);
+      }
+      cb(contract.first, bin, ContractABI(contract.second.get<string>("abi")), make_tuple(jumpis, jumpis));
+    }
+  }
+}
+
+/* Execs/sec of data with a new sender balance every time so that no prefix snapshot is reused */
+inline double measureExecs(TargetExecutive &executive, bytes data, const BenchmarkJumpis &validJumpis, uint8_t round) {
+  uint64_t execs = 500;
+  auto start = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < execs; i ++) {
+    data[32] = round;
+    data[33] = i >> 8;
+    data[34] = i & 0xFF;
+    executive.exec(data, validJumpis);
+  }
+  auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return execs / elapsed;
+}
@@ -164,3 +164,47 @@ TEST(ContractABI, DISABLED_encodeSingle)
   EXPECT_EQ(ca.encodeSingle(ll).size(), 96);
 }
 
+
+TEST(ContractABI, resizeTestData)
+{
+  string json = "[{\"constant\":false,\"inputs\":[{\"name\":\"a\",\"type\":\"bytes\"},{\"name\":\"b\",\"type\":\"uint256[]\"}],\"name\":\"add\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"}]";
+  ContractABI ca(json);
+  bytes data = ca.randomTestcase();
+  /* a holds 5 bytes, b holds 5 elements */
+  EXPECT_EQ(data.size(), 96 + 32 + 5 * 32);
+  data[96] = 0xaa;
+  data[128] = 0xbb;
+  bytes lens(data.begin(), data.begin() + 32);
+  lens[0] = 40;
+  lens[1] = 2;
+  auto resized = ca.resizeTestData(data, lens);
+  EXPECT_EQ(resized.size(), 96 + 64 + 2 * 32);
+  EXPECT_EQ(resized[96], 0xaa);
+  EXPECT_EQ(resized[160], 0xbb);
+  /* Shrinking back drops the padding, extra bytes past the values are cut */
+  resized.push_back(1);
+  EXPECT_EQ(ca.resizeTestData(resized, data).size(), data.size());
+  EXPECT_EQ(ca.resizeTestData(resized, data)[128], 0xbb);
+}
+
+TEST(ContractABI, traceEncoding)
+{
+  string json = "[{\"constant\":false,\"inputs\":[{\"name\":\"a\",\"type\":\"uint256\"},{\"name\":\"b\",\"type\":\"bytes\"}],\"name\":\"add\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"}]";
+  ContractABI ca(json);
+  bytes data(192, 0);
+  /* b holds 3 bytes */
+  data[0] = 3;
+  auto traces = ca.traceEncoding(data);
+  ASSERT_EQ(traces.size(), 2);
+  EXPECT_TRUE(traces[0].empty());
+  auto const& trace = traces[1];
+  ca.updateTestData(data);
+  ASSERT_EQ(trace.size(), ca.encodeFunctions()[0].size());
+  /* Selector, then a is the first 32 bytes value */
+  for (int i = 0; i < 4; i ++) EXPECT_EQ(trace[i], -1);
+  for (int i = 0; i < 32; i ++) EXPECT_EQ(trace[4 + i], 96 + i);
+  /* Offset and len of b, then its 3 bytes right padded */
+  for (int i = 36; i < 100; i ++) EXPECT_EQ(trace[i], -1);
+  for (int i = 0; i < 3; i ++) EXPECT_EQ(trace[100 + i], 128 + i);
+  for (size_t i = 103; i < trace.size(); i ++) EXPECT_EQ(trace[i], -1);
+}
@@ -0,0 +1,73 @@
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/Corpus.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(Corpus, saveAndLoad)
+{
+  auto folder = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  FuzzItem first(bytes(96, 1), {0, 2});
+  first.depth = 3;
+  FuzzItem second(bytes(96, 2));
+  {
+    Corpus corpus;
+    corpus.open(folder);
+    corpus.save(toBranchId(1, 2), first, 5);
+    corpus.save(toBranchId(1, 3), first, 0);
+    corpus.save(toBranchId(1, 2), second, 0);
+  }
+  auto items = Corpus::load(folder);
+  ASSERT_EQ(items.size(), 2);
+  EXPECT_EQ(items[0].data, second.data);
+  EXPECT_EQ(items[1].data, first.data);
+  EXPECT_EQ(items[1].sequence, first.sequence);
+  EXPECT_EQ(items[1].depth, 3);
+  /* Files which are not corpus testcases are raw test data */
+  EXPECT_EQ(Corpus::decode(bytes(40, 7)).data, bytes(40, 7));
+  boost::filesystem::remove_all(folder);
+}
+
+TEST(Corpus, compactIndex)
+{
+  namespace fs = boost::filesystem;
+  auto folder = (fs::temp_directory_path() / fs::unique_path()).string();
+  {
+    Corpus corpus;
+    corpus.open(folder);
+    /* Two branches whose leader changes many times */
+    for (int i = 0; i < 1000; i ++) {
+      FuzzItem item(bytes(32, (byte) i));
+      corpus.save(toBranchId(1, i % 2), item, i);
+    }
+  }
+  ifstream index((fs::path(folder) / "index.txt").string());
+  size_t numLines = 0;
+  string line;
+  while (getline(index, line)) numLines ++;
+  EXPECT_LT(numLines, 300);
+  /* Outdated testcases are removed with their lines */
+  size_t numFiles = 0;
+  for (auto it = fs::directory_iterator(folder); it != fs::directory_iterator(); it ++) numFiles ++;
+  EXPECT_LT(numFiles, 300);
+  auto items = Corpus::load(folder);
+  ASSERT_EQ(items.size(), 2);
+  EXPECT_EQ(items[0].data, bytes(32, (byte) 998));
+  EXPECT_EQ(items[1].data, bytes(32, (byte) 999));
+  fs::remove_all(folder);
+}
+
+TEST(Corpus, cover)
+{
+  /* The expensive input covering everything loses to two cheap ones */
+  vector<vector<uint64_t>> features = {{1, 2}, {1, 2, 3}, {3}, {2}, {}};
+  vector<double> costs = {1, 10, 1, 1, 1};
+  auto chosen = Corpus::cover(features, costs);
+  ASSERT_EQ(chosen.size(), 2);
+  EXPECT_EQ(chosen[0].first, 0);
+  EXPECT_EQ(chosen[0].second, vector<uint64_t>({1, 2}));
+  EXPECT_EQ(chosen[1].first, 2);
+  EXPECT_EQ(chosen[1].second, vector<uint64_t>({3}));
+}
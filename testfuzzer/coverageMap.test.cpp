@@ -0,0 +1,47 @@
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/CoverageMap.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(CoverageMap, branchId)
+{
+  auto id = toBranchId(1024, 77);
+  EXPECT_EQ(branchFrom(id), 1024);
+  EXPECT_EQ(branchTo(id), 77);
+  EXPECT_EQ(branchToString(id), "1024:77");
+}
+
+TEST(CoverageMap, record)
+{
+  CoverageMap map;
+  EXPECT_TRUE(map.record(toBranchId(10, 20)));
+  EXPECT_FALSE(map.record(toBranchId(10, 20)));
+  EXPECT_TRUE(map.record(toBranchId(10, 11), 5));
+  EXPECT_FALSE(map.record(toBranchId(10, 11), 3));
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.hits()[0], toBranchId(10, 20));
+  EXPECT_EQ(map.hitsWithValues()[1].second, 3);
+  map.clear();
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_TRUE(map.record(toBranchId(10, 20)));
+}
+
+TEST(CoverageMap, grow)
+{
+  CoverageMap map;
+  for (uint64_t i = 1; i <= 20000; i ++) map.record(toBranchId(i, i + 1));
+  EXPECT_EQ(map.size(), 20000);
+  for (uint64_t i = 1; i <= 20000; i ++) EXPECT_FALSE(map.record(toBranchId(i, i + 1)));
+}
+
+TEST(CoverageMap, hashBranch)
+{
+  auto a = toBranchId(10, 20);
+  auto b = toBranchId(30, 40);
+  EXPECT_EQ(hashBranch(hashBranch(0, a), b), hashBranch(hashBranch(0, a), b));
+  EXPECT_NE(hashBranch(hashBranch(0, a), b), hashBranch(hashBranch(0, b), a));
+  EXPECT_NE(hashBranch(0, a), hashBranch(0, b));
+}
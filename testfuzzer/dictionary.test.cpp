@@ -0,0 +1,35 @@
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/Dictionary.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(RuntimeDictionary, deduplicatesAndEvictsUseless)
+{
+  RuntimeDictionary dict(2);
+  dict.add({ bytes{1}, bytes{2}, bytes{1} });
+  EXPECT_EQ(dict.size(), 2);
+  /* bytes{1} was tried without a find, bytes{2} found something */
+  auto used = dict.snapshot();
+  for (auto &extra : used.extras) {
+    extra.uses = 4;
+    extra.finds = extra.data == bytes{2} ? 1 : 0;
+  }
+  dict.credit(used);
+  dict.add({ bytes{3} });
+  auto extras = dict.snapshot().extras;
+  ASSERT_EQ(extras.size(), 2);
+  set<bytes> values;
+  for (auto const& extra : extras) {
+    values.insert(extra.data);
+    EXPECT_EQ(extra.uses, 0);
+  }
+  EXPECT_EQ(values, (set<bytes>{ bytes{2}, bytes{3} }));
+  /* Untried entries are replaced oldest first */
+  dict.add({ bytes{4} });
+  values.clear();
+  for (auto const& extra : dict.snapshot().extras) values.insert(extra.data);
+  EXPECT_EQ(values, (set<bytes>{ bytes{2}, bytes{4} }));
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <atomic>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/ExecutorPool.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(ExecutorPool, mergesEveryCandidate)
+{
+  atomic<int> executors(0);
+  atomic<int> lastBatches(0);
+  ExecutorPool pool(3, [&]() -> OnBatchFunc {
+    executors ++;
+    return [&](Batch &batch) {
+      if (!batch.size) lastBatches ++;
+      for (size_t i = 0; i < batch.size; i ++) batch.items[i].res.cksum = batch.items[i].data[0] + batch.items[i].sequence.size();
+    };
+  });
+  vector<int> merged(256, 0);
+  {
+    BatchQueue batches(pool, [&](Batch &batch) {
+      for (size_t i = 0; i < batch.size; i ++) {
+        auto &item = batch.items[i];
+        EXPECT_EQ(item.res.cksum, item.data[0] + 1);
+        merged[item.data[0]] ++;
+      }
+    }, 10, 2);
+    for (int i = 0; i < 256; i ++) batches.push(bytes(1, i), Sequence(1, 0));
+    batches.flush();
+  }
+  for (auto count : merged) EXPECT_EQ(count, 1);
+  pool.stop();
+  EXPECT_EQ(executors, 3);
+  EXPECT_EQ(lastBatches, 3);
+}
+
+TEST(ExecutorPool, cancelAfterMergeThrows)
+{
+  ExecutorPool pool(2, []() -> OnBatchFunc { return [](Batch &) {}; });
+  int merged = 0;
+  BatchQueue batches(pool, [&](Batch &batch) {
+    merged += batch.size;
+    throw runtime_error("stop");
+  }, 4, 2);
+  EXPECT_THROW({
+    for (int i = 0; i < 100; i ++) batches.push(bytes(1, i), Sequence());
+  }, runtime_error);
+  batches.cancel();
+  EXPECT_EQ(merged, 4);
+  /* Buffers are back, the queue is usable again */
+  EXPECT_THROW({
+    for (int i = 0; i < 100; i ++) batches.push(bytes(1, i), Sequence());
+  }, runtime_error);
+  batches.cancel();
+  EXPECT_EQ(merged, 8);
+}
@@ -0,0 +1,184 @@
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/Frontier.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(Frontier, coverAndApproach)
+{
+  Frontier frontier;
+  TestcaseStore store;
+  auto item = store.add(FuzzItem(bytes(4, 0)));
+  auto a = toBranchId(10, 11);
+  auto b = toBranchId(10, 20);
+  frontier.approach(a, item, 5);
+  frontier.approach(b, item, 7);
+  EXPECT_EQ(frontier.numPredicates(), 2);
+  EXPECT_EQ(frontier.findLeader(a)->comparisonValue, 5);
+  frontier.approach(a, item, 3);
+  EXPECT_EQ(frontier.findLeader(a)->comparisonValue, 3);
+  EXPECT_EQ(frontier.getQueue().size(), 2);
+  frontier.cover(a, item);
+  EXPECT_TRUE(frontier.isCovered(a));
+  EXPECT_EQ(frontier.numPredicates(), 1);
+  EXPECT_EQ(frontier.findLeader(a)->comparisonValue, 0);
+  EXPECT_EQ(frontier.getQueue().size(), 2);
+  EXPECT_EQ(frontier.findLeader(toBranchId(1, 2)), nullptr);
+}
+
+namespace {
+  /* Tracebits and predicates reported by one execution */
+  using Report = pair<vector<BranchId>, vector<pair<BranchId, u256>>>;
+  /*
+   * Bookkeeping of the fuzzer before the frontier, kept to compare with:
+   * branches are strings, leaders and the queue are searched linearly and
+   * every execution sweeps the predicates for covered branches
+   */
+  struct LegacyFrontier {
+    vector<string> queues;
+    unordered_set<string> tracebits;
+    unordered_set<string> predicates;
+    unordered_map<string, pair<FuzzItem, u256>> leaders;
+    void merge(const FuzzItem &item, const Report &report) {
+      unordered_set<string> reportedTracebits;
+      unordered_map<string, u256> reportedPredicates;
+      for (auto branchId : report.first) reportedTracebits.insert(branchToString(branchId));
+      for (auto const& it : report.second) reportedPredicates[branchToString(it.first)] = it.second;
+      for (auto const& tracebit : reportedTracebits) {
+        if (tracebits.count(tracebit)) continue;
+        auto lIt = find_if(leaders.begin(), leaders.end(), [&](const pair<const string, pair<FuzzItem, u256>> &p) { return p.first == tracebit; });
+        if (lIt != leaders.end()) leaders.erase(lIt);
+        if (find(queues.begin(), queues.end(), tracebit) == queues.end()) queues.push_back(tracebit);
+        leaders.insert(make_pair(tracebit, make_pair(item, u256(0))));
+      }
+      for (auto const& predicate : reportedPredicates) {
+        auto lIt = find_if(leaders.begin(), leaders.end(), [&](const pair<const string, pair<FuzzItem, u256>> &p) { return p.first == predicate.first; });
+        if (lIt != leaders.end() && lIt->second.second > 0 && lIt->second.second > predicate.second) {
+          leaders.erase(lIt);
+          leaders.insert(make_pair(predicate.first, make_pair(item, predicate.second)));
+        } else if (lIt == leaders.end()) {
+          leaders.insert(make_pair(predicate.first, make_pair(item, predicate.second)));
+          queues.push_back(predicate.first);
+        }
+      }
+      for (auto const& tracebit : reportedTracebits) tracebits.insert(tracebit);
+      for (auto const& predicate : reportedPredicates) predicates.insert(predicate.first);
+      for (auto it = predicates.begin(); it != predicates.end();) {
+        if (tracebits.count(*it)) it = predicates.erase(it);
+        else it ++;
+      }
+    }
+  };
+  /* Same merge as the fuzzer does */
+  void merge(Frontier &frontier, TestcaseRef item, const Report &report) {
+    for (auto branchId : report.first) {
+      if (!frontier.isCovered(branchId)) frontier.cover(branchId, item);
+    }
+    for (auto const& it : report.second) {
+      frontier.hit(it.first);
+      auto leader = frontier.findLeader(it.first);
+      if (!leader || (leader->comparisonValue > 0 && leader->comparisonValue > it.second)) frontier.approach(it.first, item, it.second);
+    }
+  }
+}
+
+/* Bookkeeping cost per execution of the old and the new path on the same reports, as branches grow */
+TEST(Benchmark, DISABLED_frontier)
+{
+  TestcaseStore store;
+  FuzzItem item(bytes(164, 0));
+  auto testcase = store.add(item);
+  uint64_t execs = 1000;
+  for (uint64_t numBranches = 1000; numBranches <= 8000; numBranches *= 2) {
+    /* Each execution reports a handful of tracebits and predicates */
+    vector<Report> reports(execs);
+    for (uint64_t i = 0; i < execs; i ++) {
+      for (uint64_t j = 0; j < 16; j ++) {
+        auto pc = (i * 16 + j) % numBranches;
+        if (j % 4 == 0) reports[i].first.push_back(toBranchId(pc, pc + 1));
+        reports[i].second.push_back(make_pair(toBranchId(pc, pc + 2), u256(pc + 1)));
+      }
+    }
+    Report initial;
+    for (uint64_t pc = 0; pc < numBranches; pc ++) initial.second.push_back(make_pair(toBranchId(pc, pc + 1), u256(pc + 1)));
+    LegacyFrontier legacy;
+    legacy.merge(item, initial);
+    auto start = chrono::steady_clock::now();
+    for (auto const& report : reports) legacy.merge(item, report);
+    auto legacyElapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    Frontier frontier;
+    merge(frontier, testcase, initial);
+    start = chrono::steady_clock::now();
+    for (auto const& report : reports) merge(frontier, testcase, report);
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(frontier.getLeaders().size(), legacy.leaders.size());
+    cout << numBranches << " branches: " << legacyElapsed / execs << " ns/exec before, " << elapsed / execs << " ns/exec now" << endl;
+  }
+}
+
+TEST(Frontier, sharedTestcases)
+{
+  Frontier frontier;
+  TestcaseStore store(64);
+  FuzzItem item(bytes(40, 1));
+  item.res.cksum = 7;
+  auto testcase = store.add(item);
+  frontier.cover(toBranchId(1, 2), testcase);
+  frontier.approach(toBranchId(3, 4), testcase, 9);
+  EXPECT_EQ(frontier.numFresh(), 2);
+  frontier.markFuzzed(toBranchId(3, 4));
+  frontier.markFuzzed(toBranchId(3, 4));
+  EXPECT_EQ(frontier.numFresh(), 1);
+  /* Both leaders share the bytes of one testcase */
+  EXPECT_EQ(frontier.findLeader(toBranchId(1, 2))->item, frontier.findLeader(toBranchId(3, 4))->item);
+  auto loaded = frontier.findLeader(toBranchId(3, 4))->load();
+  EXPECT_EQ(loaded.data, item.data);
+  EXPECT_EQ(loaded.res.cksum, 7);
+  EXPECT_EQ(loaded.fuzzedCount, 2);
+  EXPECT_EQ(store.memory(), 64);
+  /* The second testcase does not fit, a new slab is started */
+  auto other = store.add(FuzzItem(bytes(40, 2)));
+  EXPECT_EQ(store.memory(), 128);
+  testcase.reset();
+  frontier.cover(toBranchId(1, 2), other);
+  frontier.cover(toBranchId(3, 4), other);
+  /* A new leader has not been fuzzed yet */
+  EXPECT_EQ(frontier.numFresh(), 2);
+  /* Nothing refers to the first slab anymore */
+  EXPECT_EQ(store.memory(), 64);
+  EXPECT_EQ(other->data.toBytes(), bytes(40, 2));
+}
+
+TEST(TestcaseStore, forgetFreedSlabs)
+{
+  TestcaseStore store(64);
+  for (int i = 0; i < 100; i ++) store.add(FuzzItem(bytes(40, i)));
+  /* Only the current slab is still referenced */
+  EXPECT_LE(store.numSlabs(), 2);
+  EXPECT_EQ(store.memory(), 64);
+}
+
+TEST(TestcaseStore, compactSparseSlabs)
+{
+  TestcaseStore store(64);
+  Frontier frontier;
+  /* Eight testcases per slab, one of each survives the churn as a leader */
+  for (uint64_t i = 0; i < 200; i ++) {
+    auto testcase = store.add(FuzzItem(bytes(8, (byte) i)));
+    if (i % 8 == 0) frontier.cover(toBranchId(i, i + 1), testcase);
+  }
+  EXPECT_EQ(store.memory(), 25 * 64);
+  ASSERT_TRUE(store.wantsCompaction());
+  auto id = frontier.findLeader(toBranchId(8, 9))->item->id;
+  frontier.relocate(store.compact());
+  EXPECT_FALSE(store.wantsCompaction());
+  /* The 24 leaders out of full slabs fill three, the last slab is kept */
+  EXPECT_EQ(store.memory(), 4 * 64);
+  auto leader = frontier.findLeader(toBranchId(8, 9));
+  EXPECT_EQ(leader->item->data.toBytes(), bytes(8, 8));
+  EXPECT_EQ(leader->item->id, id);
+}
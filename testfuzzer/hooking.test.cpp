@@ -0,0 +1,28 @@
+#include <iostream>
+#include <chrono>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/TargetContainer.h>
+#include "benchmark.h"
+
+using namespace fuzzer;
+using namespace std;
+
+/* Hooking every instruction versus only the ones the fuzzer analyzes */
+TEST(Benchmark, DISABLED_selectiveHooking)
+{
+  double fullTotal = 0, selectiveTotal = 0;
+  forEachBenchmarkContract([&](string name, bytes bin, ContractABI ca, const BenchmarkJumpis &validJumpis) {
+    auto data = ContractABI::postprocessTestData(ca.randomTestcase());
+    TargetContainer container;
+    auto executive = container.loadContract(bin, ca);
+    executive.hookedInstructions.set();
+    auto full = measureExecs(executive, data, validJumpis, 0);
+    executive.hookedInstructions = TargetExecutive::defaultHookedInstructions();
+    auto selective = measureExecs(executive, data, validJumpis, 1);
+    fullTotal += full;
+    selectiveTotal += selective;
+    cout << name << ": " << (uint64_t) full << " -> " << (uint64_t) selective << " execs/sec" << endl;
+  });
+  cout << "total: " << (uint64_t) fullTotal << " -> " << (uint64_t) selectiveTotal << " execs/sec" << endl;
+}
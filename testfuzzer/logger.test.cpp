@@ -0,0 +1,62 @@
+#include <iostream>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/Logger.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(Logger, ringKeepsOrderAndDropsWhenFull)
+{
+  LogRing ring(3);
+  /* Rounded up to 4 cells */
+  for (int i = 0; i < 4; i ++) EXPECT_TRUE(ring.push(i, to_string(i)));
+  EXPECT_FALSE(ring.push(4, "4"));
+  int level;
+  string message;
+  for (int i = 0; i < 4; i ++) {
+    EXPECT_TRUE(ring.pop(level, message));
+    EXPECT_EQ(level, i);
+    EXPECT_EQ(message, to_string(i));
+  }
+  EXPECT_FALSE(ring.pop(level, message));
+  EXPECT_TRUE(ring.push(5, "5"));
+}
+
+TEST(Logger, ringManyProducers)
+{
+  LogRing ring(1 << 12);
+  vector<thread> producers;
+  for (int t = 0; t < 4; t ++) {
+    producers.push_back(thread([&ring, t]() {
+      for (int i = 0; i < 1000; i ++) ring.push(t, to_string(i));
+    }));
+  }
+  for (auto &producer : producers) producer.join();
+  vector<int> next(4, 0);
+  int level;
+  string message;
+  while (ring.pop(level, message)) {
+    /* Lines of one producer stay in order */
+    EXPECT_EQ(message, to_string(next[level]));
+    next[level] ++;
+  }
+  for (auto count : next) EXPECT_EQ(count, 1000);
+}
+
+TEST(Logger, disabledLevelsAreNotBuilt)
+{
+  int built = 0;
+  auto format = [&]() { built ++; return string("line"); };
+  fuzzer::Logger::setLevel(fuzzer::Logger::INFO);
+  LOG_DEBUG(format());
+  EXPECT_EQ(built, 0);
+  LOG_INFO(format());
+  EXPECT_EQ(built, 1);
+  fuzzer::Logger::setLevel(fuzzer::Logger::NONE);
+  LOG_INFO(format());
+  EXPECT_EQ(built, 1);
+  fuzzer::Logger::flush();
+  fuzzer::Logger::setLevel(fuzzer::Logger::DEBUG);
+}
@@ -7,3 +7,205 @@
 
 using namespace fuzzer;
 using namespace std;
+
+TEST(Mutation, havocSequence)
+{
+  FuzzItem item(bytes(96, 0));
+  Mutation mutation(item, Dicts());
+  uint64_t count = 0;
+  mutation.havocSequence([&](Sequence sequence) {
+    EXPECT_GE(sequence.size(), 1);
+    EXPECT_LE(sequence.size(), MAX_SEQUENCE_LENGTH);
+    for (auto funcIdx : sequence) EXPECT_LT(funcIdx, 3);
+    count ++;
+    return FuzzItem(item.data, sequence);
+  }, 3);
+  EXPECT_EQ(count, mutation.stageMax);
+}
+
+TEST(Mutation, skipUnreadBytes)
+{
+  string json = "[{\"constant\":false,\"inputs\":[{\"name\":\"a\",\"type\":\"bytes\"}],\"name\":\"add\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"}]";
+  ContractABI ca(json);
+  FuzzItem item(ca.randomTestcase());
+  /* Only the first len, the env fields and 5 bytes of the value are read */
+  bytes live(item.data.size(), 0);
+  live[0] = 1;
+  fill(live.begin() + 32, live.begin() + 80, 1);
+  fill(live.begin() + 96, live.begin() + 101, 1);
+  Mutation mutation(item, Dicts(), ca);
+  auto onlyLive = [&](bytes data) {
+    for (uint64_t i = 0; i < data.size(); i ++) {
+      if (data[i] != item.data[i]) EXPECT_TRUE(live[i]) << "byte " << i;
+    }
+    return FuzzItem(data);
+  };
+  uint64_t flips = 0;
+  mutation.singleWalkingBit([&](bytes data) { flips ++; return onlyLive(data); });
+  EXPECT_EQ(flips, count(live.begin(), live.end(), 1) * 8);
+}
+
+TEST(Mutation, abiHavoc)
+{
+  string json = "[{\"constant\":false,\"inputs\":[{\"name\":\"a\",\"type\":\"uint8\"},{\"name\":\"b\",\"type\":\"int16\"},{\"name\":\"c\",\"type\":\"address\"}],\"name\":\"add\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"}]";
+  ContractABI ca(json);
+  FuzzItem item(ca.randomTestcase());
+  Dictionary addressDict;
+  addressDict.fromAddress(bytes(20, 0xaa));
+  Mutation mutation(item, make_tuple(Dictionary(), addressDict, Dictionary()), ca);
+  uint64_t count = 0;
+  mutation.abiHavoc(ca, [&](bytes data) {
+    EXPECT_EQ(data.size(), item.data.size());
+    /* Values stay canonical for their type */
+    EXPECT_EQ(bytes(data.begin() + 96, data.begin() + 127), bytes(31, 0));
+    EXPECT_EQ(bytes(data.begin() + 128, data.begin() + 158), bytes(30, data[158] & 0x80 ? 0xff : 0));
+    EXPECT_EQ(bytes(data.begin() + 160, data.begin() + 172), bytes(12, 0));
+    EXPECT_NE(data, item.data);
+    count ++;
+    return FuzzItem(data);
+  }, 64);
+  EXPECT_EQ(count, mutation.stageMax);
+}
+
+TEST(Mutation, trim)
+{
+  string json = "[{\"constant\":false,\"inputs\":[{\"name\":\"a\",\"type\":\"uint256\"},{\"name\":\"b\",\"type\":\"bytes\"}],\"name\":\"add\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"}]";
+  ContractABI ca(json);
+  bytes lens(32, 0);
+  /* b holds 64 bytes */
+  lens[0] = 64;
+  auto data = ca.resizeTestData(bytes(192, 0), lens);
+  FuzzItem item(data);
+  Mutation mutation(item, Dicts(), ca);
+  uint64_t rejected = 0;
+  /* The path needs at least 16 bytes of b */
+  auto keeps = [&](const FuzzItem &item) -> bool {
+    if (item.data[0] >= 16) return true;
+    rejected ++;
+    return false;
+  };
+  auto trimmed = mutation.trim(ca, [](bytes data) { return FuzzItem(data); }, keeps);
+  EXPECT_EQ(rejected, 1);
+  EXPECT_EQ(trimmed[0], 16);
+  EXPECT_LT(trimmed.size(), data.size());
+  /* Nothing is kept, the effector map learnt on the same layout stays */
+  item.data = trimmed;
+  item.eff = bytes(trimmed.size(), 0);
+  item.eff[100] = 1;
+  Mutation kept(item, Dicts(), ca);
+  auto rejectAll = [](const FuzzItem &) { return false; };
+  EXPECT_EQ(kept.trim(ca, [](bytes data) { return FuzzItem(data); }, rejectAll), trimmed);
+  EXPECT_EQ(kept.effector(), item.eff);
+}
+
+TEST(Mutation, inputToState)
+{
+  bytes data(160, 0);
+  auto magic = h256(u256("0xdeadbeefcafe"));
+  copy(magic.begin(), magic.end(), data.begin() + 96);
+  FuzzItem item(data);
+  Mutation mutation(item, Dicts());
+  vector<Comparison> comparisons = {
+    Comparison{Instruction::EQ, u256("0xdeadbeefcafe"), u256("0x1234567890ab")},
+    Comparison{Instruction::LT, 5, 1000}
+  };
+  set<bytes> seen;
+  mutation.inputToState(comparisons, [&](bytes data) {
+    seen.insert(data);
+    return FuzzItem(data);
+  });
+  EXPECT_EQ(seen.size(), mutation.stageMax);
+  auto solved = data;
+  auto expected = h256(u256("0x1234567890ab"));
+  copy(expected.begin(), expected.end(), solved.begin() + 96);
+  EXPECT_TRUE(seen.count(solved));
+  /* Nothing in the data equals 5 or 1000, only the magic is patched */
+  for (auto const& candidate : seen) {
+    EXPECT_TRUE(equal(data.begin(), data.begin() + 96, candidate.begin()));
+  }
+}
+
+TEST(Mutation, inputToStateThroughCalldata)
+{
+  bytes data(160, 0);
+  auto loaded = h256(u256("0xdeadbeef"));
+  copy(loaded.begin(), loaded.end(), data.begin() + 96);
+  FuzzItem item(data);
+  Mutation mutation(item, Dicts());
+  /* require(x + 2 == 0xcafebabe) with x loaded from calldata */
+  vector<Comparison> comparisons = {
+    Comparison{Instruction::CALLDATALOAD, u256("0xdeadbeef"), 4},
+    Comparison{Instruction::EQ, u256("0xdeadbef1"), u256("0xcafebabe")}
+  };
+  set<bytes> seen;
+  mutation.inputToState(comparisons, [&](bytes data) {
+    seen.insert(data);
+    return FuzzItem(data);
+  });
+  auto solved = data;
+  auto expected = h256(u256("0xcafebabc"));
+  copy(expected.begin(), expected.end(), solved.begin() + 96);
+  EXPECT_TRUE(seen.count(solved));
+}
+
+TEST(Mutation, overwriteWithRuntimeDictionary)
+{
+  FuzzItem item(bytes(128, 0));
+  Dictionary code, runtime;
+  code.fromAddress(bytes{0x56});
+  runtime.fromAddress(bytes{0x12, 0x34});
+  Mutation mutation(item, make_tuple(code, Dictionary(), runtime));
+  uint64_t count = 0;
+  mutation.overwriteWithDictionary([&](bytes data) {
+    /* Code constants first, right aligned in a word */
+    if (count < 4) {
+      EXPECT_EQ(data[32 * count + 31], 0x56);
+    } else {
+      auto pos = 32 * (count - 4) + 30;
+      EXPECT_EQ(data[pos], 0x12);
+      EXPECT_EQ(data[pos + 1], 0x34);
+    }
+    FuzzItem ret(data);
+    ret.depth = count == 5;
+    count ++;
+    return ret;
+  });
+  EXPECT_EQ(count, 8);
+  auto const& extra = mutation.runtimeDictionary().extras[0];
+  EXPECT_EQ(extra.uses, 4);
+  EXPECT_EQ(extra.finds, 1);
+}
+
+TEST(Mutation, localSearch)
+{
+  FuzzItem item(bytes(160, 0));
+  Mutation mutation(item, Dicts());
+  /* Only the second value is compared, with 1000003 */
+  u256 target = 1000003;
+  auto distance = [&](const FuzzItem &item) -> u256 {
+    auto value = fromBigEndian<u256>(bytesConstRef(item.data.data() + 128, 32));
+    return value > target ? value - target : target - value;
+  };
+  bytes solved;
+  mutation.localSearch([&](bytes data) {
+    FuzzItem ret(data);
+    if (!distance(ret)) solved = data;
+    return ret;
+  }, distance, distance(item));
+  ASSERT_EQ(solved.size(), item.data.size());
+  EXPECT_EQ(fromBigEndian<u256>(bytesConstRef(solved.data() + 128, 32)), target);
+  EXPECT_LT(mutation.stageCur, 100);
+}
+
+TEST(Mutation, focusOnTaintedBytes)
+{
+  FuzzItem item(bytes(160, 0));
+  Mutation mutation(item, Dicts());
+  mutation.focus(Taint{100, 101, 500});
+  mutation.singleWalkingBit([&](bytes data) {
+    for (uint64_t i = 0; i < data.size(); i ++) {
+      if (data[i] != item.data[i]) EXPECT_TRUE(i == 100 || i == 101) << "byte " << i;
+    }
+    return FuzzItem(data);
+  });
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include <liboracle/OracleFactory.h>
+
+using namespace std;
+
+namespace {
+  OracleEvent rootCall(bytes const& data, u256 wei) {
+    OracleEvent event;
+    event.inst = Instruction::CALL;
+    event.data = bytesConstRef(&data);
+    event.wei = wei;
+    event.caller = Address(0xf0);
+    event.callee = Address(0xf1);
+    return event;
+  }
+}
+
+TEST(OracleFactory, streamingDetectors)
+{
+  OracleFactory oracle;
+  bytes data = fromHex("0xaabbccdd000000000000000000000000000000000000000000000000000000000000c0de");
+  /* Timestamp without ether moved is no dependency */
+  oracle.initialize();
+  oracle.save(rootCall(data, 0));
+  OracleEvent timestamp;
+  timestamp.level = 1;
+  timestamp.inst = Instruction::TIMESTAMP;
+  oracle.save(timestamp);
+  oracle.finalize();
+  EXPECT_FALSE(oracle.current()[TIME_DEPENDENCY]);
+  /* Reported as soon as both events were seen */
+  oracle.initialize();
+  oracle.save(rootCall(data, 10));
+  oracle.save(timestamp);
+  EXPECT_TRUE(oracle.current()[TIME_DEPENDENCY]);
+  EXPECT_TRUE(oracle.analyze()[TIME_DEPENDENCY]);
+  /* Delegate to an address taken from the call data, without sending ether */
+  OracleEvent delegate;
+  delegate.level = 1;
+  delegate.inst = Instruction::DELEGATECALL;
+  delegate.callee = Address(0xc0de);
+  oracle.save(delegate);
+  EXPECT_TRUE(oracle.current()[DELEGATE_CALL]);
+  EXPECT_FALSE(oracle.current()[FREEZING]);
+  oracle.finalize();
+  EXPECT_TRUE(oracle.current()[FREEZING]);
+  /* Nested exception while the transaction succeeds */
+  oracle.initialize();
+  oracle.save(rootCall(data, 0));
+  OracleEvent invalid;
+  invalid.level = 2;
+  invalid.inst = Instruction::INVALID;
+  oracle.save(invalid);
+  oracle.finalize();
+  EXPECT_TRUE(oracle.current()[EXCEPTION_DISORDER]);
+  EXPECT_FALSE(oracle.current()[TIME_DEPENDENCY]);
+  /* Nothing else was found */
+  auto vulnerabilities = oracle.analyze();
+  for (uint8_t i : {GASLESS_SEND, NUMBER_DEPENDENCY, REENTRANCY, OVERFLOW, UNDERFLOW}) EXPECT_FALSE(vulnerabilities[i]);
+  Findings replayed;
+  replayed.set(REENTRANCY);
+  oracle.merge(replayed);
+  EXPECT_TRUE(oracle.analyze()[REENTRANCY]);
+}
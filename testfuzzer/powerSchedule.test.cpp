@@ -0,0 +1,25 @@
+#include "gtest/gtest.h"
+#include <libfuzzer/PowerSchedule.h>
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(PowerSchedule, leaderEnergy)
+{
+  BranchStats rare, frequent;
+  rare.hits = 2;
+  frequent.hits = 200;
+  /* Exploit only scales by exec cost */
+  EXPECT_EQ(leaderEnergy(EXPLOIT, 10, rare, 50, 0), 1);
+  EXPECT_GT(leaderEnergy(FAST, 10, rare, 50, 0), leaderEnergy(FAST, 10, frequent, 50, 0));
+  EXPECT_EQ(leaderEnergy(COE, 10, frequent, 50, 0), 0);
+  EXPECT_GT(leaderEnergy(COE, 10, rare, 50, 0), 0);
+  /* Closing in on the comparison value earns energy */
+  BranchStats progress;
+  progress.initialValue = u256(1) << 128;
+  EXPECT_GT(leaderEnergy(DISTANCE, 3, progress, 50, 0), leaderEnergy(DISTANCE, u256(1) << 100, progress, 50, 0));
+  /* Expensive leaders get less havoc */
+  BranchStats slow;
+  slow.execCost = 400;
+  EXPECT_LT(leaderEnergy(EXPLOIT, 10, slow, 50, 100), 1);
+}
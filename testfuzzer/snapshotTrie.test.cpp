@@ -0,0 +1,78 @@
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/TargetContainer.h>
+#include <libfuzzer/SnapshotTrie.h>
+#include "benchmark.h"
+
+using namespace fuzzer;
+using namespace std;
+
+TEST(SnapshotTrie, evictLeastRecentlyUsed)
+{
+  PrefixRecord record{ProgramSnapshot{State(0), 0, 0, 0}, {}, {}, 0, {}, {}, 0};
+  auto build = [&]() { return record; };
+  SnapshotTrie trie(record.memory() * 2);
+  auto root = h256(1);
+  auto first = SnapshotTrie::childKey(root, bytes{1});
+  auto second = SnapshotTrie::childKey(first, bytes{2});
+  EXPECT_NE(first, SnapshotTrie::childKey(root, bytes{2}));
+  trie.insert(root, build);
+  trie.insert(first, build);
+  EXPECT_NE(trie.find(root), nullptr);
+  trie.insert(second, build);
+  EXPECT_EQ(trie.size(), 2);
+  EXPECT_EQ(trie.find(first), nullptr);
+  EXPECT_NE(trie.find(root), nullptr);
+  EXPECT_NE(trie.find(second), nullptr);
+}
+
+TEST(SnapshotTrie, snapshotOnlyReusedPrefixes)
+{
+  PrefixRecord record{ProgramSnapshot{State(0), 0, 0, 0}, {}, {}, 0, {}, {}, 0};
+  int builds = 0;
+  auto build = [&]() -> PrefixRecord { builds ++; return record; };
+  SnapshotTrie trie(record.memory() * 2);
+  auto key = h256(1);
+  EXPECT_FALSE(trie.wanted(key));
+  EXPECT_TRUE(trie.wanted(key));
+  trie.insert(key, build);
+  trie.insert(key, build);
+  EXPECT_EQ(builds, 1);
+  EXPECT_FALSE(trie.wanted(key));
+}
+
+/* Execs/sec without prefix snapshots versus with them, on fresh and on shared prefixes */
+TEST(Benchmark, DISABLED_snapshotTrie)
+{
+  double offTotal = 0, onTotal = 0, offSharedTotal = 0, onSharedTotal = 0;
+  /* Only the last word of test data changes, as most havoc mutants do */
+  auto measureShared = [](TargetExecutive &executive, bytes data, const BenchmarkJumpis &validJumpis) -> double {
+    uint64_t execs = 500;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < execs; i ++) {
+      data[data.size() - 1] = i & 0xFF;
+      executive.exec(data, validJumpis);
+    }
+    return execs / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  };
+  forEachBenchmarkContract([&](string name, bytes bin, ContractABI ca, const BenchmarkJumpis &validJumpis) {
+    auto data = ContractABI::postprocessTestData(ca.randomTestcase());
+    TargetContainer container;
+    auto executive = container.loadContract(bin, ca);
+    executive.snapshots = make_shared<SnapshotTrie>(0);
+    auto off = measureExecs(executive, data, validJumpis, 0);
+    auto offShared = measureShared(executive, data, validJumpis);
+    executive.snapshots = make_shared<SnapshotTrie>(SNAPSHOT_BUDGET);
+    auto on = measureExecs(executive, data, validJumpis, 1);
+    auto onShared = measureShared(executive, data, validJumpis);
+    offTotal += off;
+    onTotal += on;
+    offSharedTotal += offShared;
+    onSharedTotal += onShared;
+    cout << name << ": " << (uint64_t) off << " -> " << (uint64_t) on << " execs/sec, shared prefixes ";
+    cout << (uint64_t) offShared << " -> " << (uint64_t) onShared << " execs/sec" << endl;
+  });
+  cout << "total: " << (uint64_t) offTotal << " -> " << (uint64_t) onTotal << " execs/sec, shared prefixes ";
+  cout << (uint64_t) offSharedTotal << " -> " << (uint64_t) onSharedTotal << " execs/sec" << endl;
+}
@@ -0,0 +1,34 @@
+#include <iostream>
+#include <chrono>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/TargetContainer.h>
+#include "benchmark.h"
+
+using namespace fuzzer;
+using namespace std;
+
+/* State over OverlayDB versus the flat cache-only State */
+TEST(Benchmark, DISABLED_stateBackend)
+{
+  double trieTotal = 0, flatTotal = 0;
+  forEachBenchmarkContract([&](string name, bytes bin, ContractABI ca, const BenchmarkJumpis &validJumpis) {
+    auto data = ContractABI::postprocessTestData(ca.randomTestcase());
+    TargetContainer trieContainer(TRIE_STATE);
+    auto trieExecutive = trieContainer.loadContract(bin, ca);
+    auto trie = measureExecs(trieExecutive, data, validJumpis, 0);
+    TargetContainer flatContainer(FLAT_STATE);
+    auto flatExecutive = flatContainer.loadContract(bin, ca);
+    auto flat = measureExecs(flatExecutive, data, validJumpis, 0);
+    trieTotal += trie;
+    flatTotal += flat;
+    cout << name << ": " << (uint64_t) trie << " -> " << (uint64_t) flat << " execs/sec" << endl;
+  });
+  cout << "total: " << (uint64_t) trieTotal << " -> " << (uint64_t) flatTotal << " execs/sec" << endl;
+}
+
+TEST(StateBackend, flatStateRefusesCommit)
+{
+  State state(0, State::Flat);
+  EXPECT_THROW(state.commit(State::CommitBehaviour::KeepEmptyAccounts), InterfaceNotSupported);
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include <libfuzzer/TargetContainer.h>
+
+using namespace fuzzer;
+using namespace std;
+
+namespace {
+  /* Labels of the 32 bytes value at offset 4 of the call data */
+  Taint argument(vector<int> const& trace) {
+    Taint ret;
+    for (int i = 4; i < 36; i ++) ret.push_back(trace[i]);
+    sort(ret.begin(), ret.end());
+    return ret;
+  }
+}
+
+TEST(TaintTracker, labelsReachConditions)
+{
+  string json = "[{\"constant\":false,\"inputs\":[{\"name\":\"x\",\"type\":\"uint256\"}],\"name\":\"f\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"},"
+    "{\"constant\":false,\"inputs\":[{\"name\":\"x\",\"type\":\"uint256\"}],\"name\":\"g\",\"outputs\":[],\"payable\":false,\"stateMutability\":\"nonpayable\",\"type\":\"function\"}]";
+  /*
+   * Both functions run the same code:
+   *   0: if (sload(0)) goto 6     JUMPI at 5
+   *   7: mstore(0, x + 1)
+   *  16: if (mload(0) == 7) stop  JUMPI at 24
+   *  25: sstore(0, x)
+   */
+  auto runtime = fromHex(
+    "600054600657" "5b"
+    "600435600101600052"
+    "600051600714602057"
+    "600435600055" "00"
+    "5b00"
+  );
+  /* Copy the runtime code and return it */
+  auto code = fromHex("60" + toHex(bytes{(byte) runtime.size()}) + "600c600039" + "60" + toHex(bytes{(byte) runtime.size()}) + "6000f3");
+  code.insert(code.end(), runtime.begin(), runtime.end());
+  ContractABI ca(json);
+  auto data = ContractABI::postprocessTestData(ca.randomTestcase());
+  auto traces = ca.traceEncoding(data);
+  ASSERT_EQ(traces.size(), 3);
+  auto f = argument(traces[1]);
+  auto g = argument(traces[2]);
+  /* Both arguments are 5, stored by f then read back by g */
+  for (auto offset : f) data[offset] = 0;
+  for (auto offset : g) data[offset] = 0;
+  data[f.back()] = 5;
+  data[g.back()] = 5;
+  TargetContainer container;
+  auto executive = container.loadContract(code, ca);
+  executive.traceTaint = true;
+  executive.exec(data, make_tuple(unordered_set<uint64_t>(), unordered_set<uint64_t>()));
+  auto const& taint = executive.lastTaint;
+  /* Through CALLDATALOAD, ADD, MSTORE and MLOAD in both calls */
+  ASSERT_TRUE(taint.count(24));
+  auto both = f;
+  TaintTracker::merge(both, g);
+  EXPECT_EQ(taint.at(24), both);
+  /* Through SSTORE in f and SLOAD in g */
+  ASSERT_TRUE(taint.count(5));
+  EXPECT_EQ(taint.at(5), f);
+}